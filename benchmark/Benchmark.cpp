@@ -0,0 +1,41 @@
+#include <Benchmark.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace xconsole
+{
+
+static volatile uint64_t sink = 0;
+
+Benchmark::Benchmark( int argc, char **argv ) :
+	min_time( 0.25 )
+{
+	for( int k = 1; k + 1 < argc; k += 2 )
+		if( std::strcmp( argv[k], "--filter" ) == 0 )
+			filter = argv[k + 1];
+		else if( std::strcmp( argv[k], "--time" ) == 0 )
+			min_time = std::atoi( argv[k + 1] ) / 1000.0;
+}
+
+void Benchmark::Use( uint64_t value )
+{
+	sink = sink + value;
+}
+
+void Benchmark::Report( const std::string &name, uint64_t operations, uint64_t bytes, double seconds )
+{
+	std::printf(
+		"{\"name\": \"%s\", \"operations\": %llu, \"bytes\": %llu, \"seconds\": %.6f, "
+		"\"ns_per_operation\": %.3f, \"mb_per_second\": %.2f}\n",
+		name.c_str( ),
+		static_cast<unsigned long long>( operations ),
+		static_cast<unsigned long long>( bytes ),
+		seconds,
+		seconds * 1e9 / static_cast<double>( operations ),
+		static_cast<double>( bytes ) / seconds / ( 1024.0 * 1024.0 )
+	);
+	std::fflush( stdout );
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace xconsole
+{
+
+/*!
+ \brief Runs benchmarks and prints one JSON object per result.
+
+ Every benchmark is a function that performs the provided amount of
+ operations and returns how many bytes they processed. It's run with more
+ and more operations until it takes long enough to be measured reliably.
+ */
+class Benchmark
+{
+public:
+	/*!
+	 \brief Parse the command line.
+
+	 Accepts --filter <text> to only run benchmarks whose name contains the
+	 text and --time <ms> to change how long each benchmark runs for.
+
+	 \param argc Amount of arguments.
+	 \param argv Arguments.
+	 */
+	Benchmark( int argc, char **argv );
+
+	/*!
+	 \brief Run a benchmark and print its result.
+
+	 \param name Name of the benchmark.
+	 \param function Function to run, called with the amount of operations.
+	 */
+	template<typename Function>
+	void Run( const std::string &name, Function function )
+	{
+		if( !filter.empty( ) && name.find( filter ) == std::string::npos )
+			return;
+
+		// warms up caches and the branch predictor before timing
+		function( 1024 );
+
+		uint64_t operations = 1024;
+		while( true )
+		{
+			const auto start = std::chrono::steady_clock::now( );
+			const uint64_t bytes = function( operations );
+			const double seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now( ) - start
+			).count( );
+
+			if( seconds >= min_time || operations >= max_operations )
+			{
+				Report( name, operations, bytes, seconds );
+				return;
+			}
+
+			operations *= seconds > min_time / 16 ? 2 : 8;
+		}
+	}
+
+	/*!
+	 \brief Keep a value from being optimized away.
+
+	 \param value Value the compiler must assume is used.
+	 */
+	static void Use( uint64_t value );
+
+private:
+	void Report( const std::string &name, uint64_t operations, uint64_t bytes, double seconds );
+
+	static const uint64_t max_operations = uint64_t( 1 ) << 40;
+
+	std::string filter;
+	double min_time;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,502 @@
+#include <Benchmark.hpp>
+#include <ByteBuffer.hpp>
+#include <Protocol.hpp>
+#include <SegmentedBuffer.hpp>
+#include <Varint.hpp>
+#include <Writer.hpp>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+// values are written in batches that fit in the cache, then the buffer starts over
+static const size_t batch_values = 4096;
+static const size_t batch_records = 256;
+static const size_t corpus_size = 4096;
+
+// big buffers are built from scratch this many bytes at a time
+static const size_t large_size = 8 * 1024 * 1024;
+
+struct Spew
+{
+	int32_t type;
+	int32_t level;
+	uint32_t group;
+	int32_t color;
+	std::string message;
+};
+
+template<typename T>
+static void BenchmarkPrimitive( xconsole::Benchmark &benchmark, const char *name )
+{
+	MultiLibrary::ByteBuffer buffer;
+	buffer.Reserve( batch_values * sizeof( T ) );
+
+	benchmark.Run( std::string( "encode/" ) + name, [&buffer]( uint64_t operations )
+	{
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_values == 0 )
+				buffer.Clear( );
+
+			buffer << static_cast<T>( k );
+		}
+
+		xconsole::Benchmark::Use( static_cast<uint64_t>( buffer.Size( ) ) );
+		return operations * sizeof( T );
+	} );
+
+	benchmark.Run( std::string( "write/" ) + name, [&buffer]( uint64_t operations )
+	{
+		for( uint64_t k = 0; k < operations; )
+		{
+			buffer.Clear( );
+			xconsole::BufferWriter writer( buffer );
+			for( size_t n = 0; n < batch_values && k < operations; ++n, ++k )
+				writer << static_cast<T>( k );
+		}
+
+		xconsole::Benchmark::Use( static_cast<uint64_t>( buffer.Size( ) ) );
+		return operations * sizeof( T );
+	} );
+
+	buffer.Clear( );
+	for( size_t k = 0; k < batch_values; ++k )
+		buffer << static_cast<T>( k );
+
+	benchmark.Run( std::string( "decode/" ) + name, [&buffer]( uint64_t operations )
+	{
+		uint64_t sum = 0;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_values == 0 )
+				buffer.Seek( 0 );
+
+			T value = T( );
+			buffer >> value;
+			sum += static_cast<uint64_t>( value );
+		}
+
+		xconsole::Benchmark::Use( sum );
+		return operations * sizeof( T );
+	} );
+}
+
+template<typename String, typename Character>
+static void BenchmarkString( xconsole::Benchmark &benchmark, const char *name, const String &text )
+{
+	const uint64_t size = ( text.size( ) + 1 ) * sizeof( Character );
+	MultiLibrary::ByteBuffer buffer;
+	buffer.Reserve( static_cast<size_t>( size * batch_records ) );
+
+	benchmark.Run( std::string( "encode/" ) + name, [&]( uint64_t operations )
+	{
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_records == 0 )
+				buffer.Clear( );
+
+			buffer << text;
+		}
+
+		xconsole::Benchmark::Use( static_cast<uint64_t>( buffer.Size( ) ) );
+		return operations * size;
+	} );
+
+	buffer.Clear( );
+	for( size_t k = 0; k < batch_records; ++k )
+		buffer << text;
+
+	benchmark.Run( std::string( "decode/" ) + name, [&]( uint64_t operations )
+	{
+		uint64_t sum = 0;
+		String value;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_records == 0 )
+				buffer.Seek( 0 );
+
+			value.clear( );
+			buffer >> value;
+			sum += value.size( );
+		}
+
+		xconsole::Benchmark::Use( sum );
+		return operations * size;
+	} );
+}
+
+static void BenchmarkVarint( xconsole::Benchmark &benchmark )
+{
+	// mostly small values, like spew types, levels and groups, with some large ones
+	std::mt19937 random( 2 );
+	std::vector<uint64_t> values( batch_values );
+	for( uint64_t &value : values )
+		value = random( ) % 8 != 0 ? random( ) % 200 : ( static_cast<uint64_t>( random( ) ) << 20 );
+
+	MultiLibrary::ByteBuffer buffer;
+	buffer.Reserve( batch_values * xconsole::max_varint_size );
+
+	benchmark.Run( "write/varint", [&]( uint64_t operations )
+	{
+		uint64_t bytes = 0;
+		for( uint64_t k = 0; k < operations; )
+		{
+			bytes += static_cast<uint64_t>( buffer.Size( ) );
+			buffer.Clear( );
+			xconsole::BufferWriter writer( buffer );
+			for( size_t n = 0; n < batch_values && k < operations; ++n, ++k )
+				xconsole::WriteVarint( writer, values[n] );
+		}
+
+		return bytes + static_cast<uint64_t>( buffer.Size( ) );
+	} );
+
+	buffer.Clear( );
+	for( uint64_t value : values )
+		xconsole::WriteVarint( buffer, value );
+
+	const uint64_t batch_bytes = static_cast<uint64_t>( buffer.Size( ) );
+	benchmark.Run( "view/varint", [&]( uint64_t operations )
+	{
+		uint64_t sum = 0;
+		xconsole::BufferView view;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_values == 0 )
+				view = xconsole::BufferView( buffer.GetBuffer( ), static_cast<size_t>( batch_bytes ) );
+
+			uint64_t value = 0;
+			xconsole::ReadVarint( view, value );
+			sum += value;
+		}
+
+		xconsole::Benchmark::Use( sum );
+		return operations * batch_bytes / batch_values;
+	} );
+}
+
+static void BenchmarkCString( xconsole::Benchmark &benchmark, const std::string &text )
+{
+	const uint64_t size = text.size( ) + 1;
+	MultiLibrary::ByteBuffer buffer;
+	buffer.Reserve( static_cast<size_t>( size * batch_records ) );
+
+	benchmark.Run( "encode/cstring", [&]( uint64_t operations )
+	{
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_records == 0 )
+				buffer.Clear( );
+
+			buffer << text.c_str( );
+		}
+
+		xconsole::Benchmark::Use( static_cast<uint64_t>( buffer.Size( ) ) );
+		return operations * size;
+	} );
+
+	buffer.Clear( );
+	for( size_t k = 0; k < batch_records; ++k )
+		buffer << text.c_str( );
+
+	std::vector<char> value( text.size( ) + 1 );
+	benchmark.Run( "decode/cstring", [&]( uint64_t operations )
+	{
+		uint64_t sum = 0;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_records == 0 )
+				buffer.Seek( 0 );
+
+			buffer >> value.data( );
+			sum += static_cast<uint8_t>( value[0] );
+		}
+
+		xconsole::Benchmark::Use( sum );
+		return operations * size;
+	} );
+}
+
+static std::vector<Spew> MakeCorpus( )
+{
+	// shaped like a busy server: mostly short lines, some long ones and the
+	// odd huge dump, over a handful of groups and colors
+	std::mt19937 random( 1234 );
+	std::uniform_int_distribution<int> percent( 0, 99 );
+	std::uniform_int_distribution<int> letter( 'a', 'z' );
+	const int32_t colors[] = { 0x00FFFFFF, 0x0000FFFF, 0x000000FF, 0x0088FF88 };
+
+	std::vector<Spew> corpus( corpus_size );
+	for( Spew &spew : corpus )
+	{
+		const int size_class = percent( random );
+		size_t length = 0;
+		if( size_class < 60 )
+			length = std::uniform_int_distribution<size_t>( 16, 64 )( random );
+		else if( size_class < 90 )
+			length = std::uniform_int_distribution<size_t>( 64, 160 )( random );
+		else if( size_class < 99 )
+			length = std::uniform_int_distribution<size_t>( 160, 512 )( random );
+		else
+			length = std::uniform_int_distribution<size_t>( 512, 2048 )( random );
+
+		const int kind = percent( random );
+		spew.type = kind < 85 ? 0 : ( kind < 97 ? 1 : 2 );
+		spew.level = percent( random ) < 90 ? 1 : 2;
+		spew.group = static_cast<uint32_t>( percent( random ) % 8 );
+		spew.color = colors[percent( random ) < 80 ? 0 : percent( random ) % 4];
+		spew.message.resize( length );
+		for( char &ch : spew.message )
+			ch = static_cast<char>( letter( random ) );
+
+		spew.message.back( ) = '\n';
+	}
+
+	return corpus;
+}
+
+static void BenchmarkSpew( xconsole::Benchmark &benchmark )
+{
+	const std::vector<Spew> corpus = MakeCorpus( );
+	MultiLibrary::ByteBuffer buffer;
+	buffer.Reserve( 1024 * 1024 );
+	xconsole::SpewState state;
+
+	benchmark.Run( "encode/spew", [&]( uint64_t operations )
+	{
+		uint64_t bytes = 0;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			// every frame starts over, like the server's batches
+			if( k % batch_records == 0 )
+			{
+				bytes += static_cast<uint64_t>( buffer.Size( ) );
+				buffer.Clear( );
+				state.Reset( );
+			}
+
+			const Spew &spew = corpus[k % corpus_size];
+			xconsole::EncodeSpewRecord(
+				buffer,
+				state,
+				spew.type,
+				spew.level,
+				spew.group,
+				spew.color,
+				k,
+				k * 1000,
+				spew.message.data( ),
+				spew.message.size( )
+			);
+		}
+
+		return bytes + static_cast<uint64_t>( buffer.Size( ) );
+	} );
+
+	// like the server, which writes each record with its own writer
+	benchmark.Run( "write/spew", [&]( uint64_t operations )
+	{
+		uint64_t bytes = 0;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % batch_records == 0 )
+			{
+				bytes += static_cast<uint64_t>( buffer.Size( ) );
+				buffer.Clear( );
+				state.Reset( );
+			}
+
+			const Spew &spew = corpus[k % corpus_size];
+			xconsole::BufferWriter writer( buffer );
+			xconsole::EncodeSpewRecord(
+				writer,
+				state,
+				spew.type,
+				spew.level,
+				spew.group,
+				spew.color,
+				k,
+				k * 1000,
+				spew.message.data( ),
+				spew.message.size( )
+			);
+		}
+
+		return bytes + static_cast<uint64_t>( buffer.Size( ) );
+	} );
+
+	// one frame holding the whole corpus, decoded over and over
+	buffer.Clear( );
+	state.Reset( );
+	for( size_t k = 0; k < corpus_size; ++k )
+	{
+		const Spew &spew = corpus[k];
+		xconsole::EncodeSpewRecord(
+			buffer,
+			state,
+			spew.type,
+			spew.level,
+			spew.group,
+			spew.color,
+			k,
+			k * 1000,
+			spew.message.data( ),
+			spew.message.size( )
+		);
+	}
+
+	const uint64_t corpus_bytes = static_cast<uint64_t>( buffer.Size( ) );
+	benchmark.Run( "decode/spew", [&]( uint64_t operations )
+	{
+		uint64_t sum = 0;
+		xconsole::RecordHeader header;
+		xconsole::SpewRecord record;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % corpus_size == 0 )
+			{
+				buffer.Seek( 0 );
+				state.Reset( );
+			}
+
+			xconsole::DecodeRecordHeader( buffer, header );
+			xconsole::DecodeSpewRecord( buffer, header, state, record );
+			sum += record.message.size( );
+		}
+
+		xconsole::Benchmark::Use( sum );
+		return operations * corpus_bytes / corpus_size;
+	} );
+
+	benchmark.Run( "view/spew", [&]( uint64_t operations )
+	{
+		uint64_t sum = 0;
+		xconsole::BufferView view;
+		xconsole::RecordHeader header;
+		xconsole::SpewRecordView record;
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			if( k % corpus_size == 0 )
+			{
+				view = xconsole::BufferView( buffer.GetBuffer( ), static_cast<size_t>( corpus_bytes ) );
+				state.Reset( );
+			}
+
+			xconsole::DecodeRecordHeader( view, header );
+			xconsole::DecodeSpewRecord( view, header, state, record );
+			sum += record.message.size;
+		}
+
+		xconsole::Benchmark::Use( sum );
+		return operations * corpus_bytes / corpus_size;
+	} );
+}
+
+static void BenchmarkLarge( xconsole::Benchmark &benchmark )
+{
+	uint8_t record[160];
+	std::memset( record, 'x', sizeof( record ) );
+
+	benchmark.Run( "append/bytebuffer", [&record]( uint64_t operations )
+	{
+		uint64_t size = 0;
+		for( uint64_t k = 0; k < operations; )
+		{
+			MultiLibrary::ByteBuffer buffer;
+			for( ; k < operations && static_cast<size_t>( buffer.Size( ) ) < large_size; ++k )
+				buffer.Write( record, sizeof( record ) );
+
+			size += static_cast<uint64_t>( buffer.Size( ) );
+		}
+
+		xconsole::Benchmark::Use( size );
+		return operations * sizeof( record );
+	} );
+
+	MultiLibrary::ChunkPool pool( 64 * 1024, large_size / ( 64 * 1024 ) );
+	benchmark.Run( "append/segmented", [&record, &pool]( uint64_t operations )
+	{
+		uint64_t size = 0;
+		for( uint64_t k = 0; k < operations; )
+		{
+			MultiLibrary::SegmentedBuffer buffer( pool );
+			for( ; k < operations && static_cast<size_t>( buffer.Size( ) ) < large_size; ++k )
+				buffer.Write( record, sizeof( record ) );
+
+			size += static_cast<uint64_t>( buffer.Size( ) );
+		}
+
+		xconsole::Benchmark::Use( size );
+		return operations * sizeof( record );
+	} );
+
+	// a queue that stays about the same size, like a history
+	MultiLibrary::ByteBuffer queue;
+	benchmark.Run( "queue/bytebuffer", [&record, &queue]( uint64_t operations )
+	{
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			queue.Seek( 0, MultiLibrary::SEEKMODE_END );
+			queue.Write( record, sizeof( record ) );
+			if( static_cast<size_t>( queue.Size( ) ) > large_size )
+			{
+				// dropping the start moves everything that's left
+				const size_t size = static_cast<size_t>( queue.Size( ) ) - large_size / 2;
+				std::memmove( queue.GetBuffer( ), queue.GetBuffer( ) + large_size / 2, size );
+				queue.Resize( size );
+			}
+		}
+
+		xconsole::Benchmark::Use( static_cast<uint64_t>( queue.Size( ) ) );
+		return operations * sizeof( record );
+	} );
+
+	MultiLibrary::SegmentedBuffer segmented( pool );
+	benchmark.Run( "queue/segmented", [&record, &segmented]( uint64_t operations )
+	{
+		for( uint64_t k = 0; k < operations; ++k )
+		{
+			segmented.Seek( 0, MultiLibrary::SEEKMODE_END );
+			segmented.Write( record, sizeof( record ) );
+			if( static_cast<size_t>( segmented.Size( ) ) > large_size )
+				segmented.Trim( large_size / 2 );
+		}
+
+		xconsole::Benchmark::Use( static_cast<uint64_t>( segmented.Size( ) ) );
+		return operations * sizeof( record );
+	} );
+}
+
+int main( int argc, char **argv )
+{
+	xconsole::Benchmark benchmark( argc, argv );
+
+	BenchmarkPrimitive<bool>( benchmark, "bool" );
+	BenchmarkPrimitive<int8_t>( benchmark, "int8" );
+	BenchmarkPrimitive<uint8_t>( benchmark, "uint8" );
+	BenchmarkPrimitive<int16_t>( benchmark, "int16" );
+	BenchmarkPrimitive<uint16_t>( benchmark, "uint16" );
+	BenchmarkPrimitive<int32_t>( benchmark, "int32" );
+	BenchmarkPrimitive<uint32_t>( benchmark, "uint32" );
+	BenchmarkPrimitive<int64_t>( benchmark, "int64" );
+	BenchmarkPrimitive<uint64_t>( benchmark, "uint64" );
+	BenchmarkPrimitive<float>( benchmark, "float" );
+	BenchmarkPrimitive<double>( benchmark, "double" );
+	BenchmarkPrimitive<char>( benchmark, "char" );
+	BenchmarkPrimitive<wchar_t>( benchmark, "wchar" );
+
+	const std::string text = "Lua Error: addons/example/lua/autorun/init.lua:12";
+	BenchmarkCString( benchmark, text );
+	BenchmarkString<std::string, char>( benchmark, "string", text );
+	BenchmarkString<std::wstring, wchar_t>(
+		benchmark,
+		"wstring",
+		std::wstring( text.begin( ), text.end( ) )
+	);
+
+	BenchmarkVarint( benchmark );
+	BenchmarkSpew( benchmark );
+	BenchmarkLarge( benchmark );
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include <FakeClient.hpp>
+#include <ByteBuffer.hpp>
+#include <MemoryBuffer.hpp>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace xconsole
+{
+
+static const size_t max_frame_size = 16 * 1024 * 1024;
+
+static uint64_t MonotonicNanoseconds( )
+{
+	return static_cast<uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now( ).time_since_epoch( )
+	).count( ) );
+}
+
+FakeClient::FakeClient( int delay, const HelloRecord &hello ) :
+	read_delay( delay ),
+	hello_record( hello ),
+	socket_fd( -1 ),
+	records( 0 ),
+	lost( 0 ),
+	frames( 0 ),
+	errors( 0 )
+{ }
+
+FakeClient::~FakeClient( )
+{
+	Join( );
+}
+
+bool FakeClient::Start( const std::string &path )
+{
+	sockaddr_un address;
+	std::memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( path.empty( ) || path.size( ) >= sizeof( address.sun_path ) )
+		return false;
+
+	// a leading @ stands for the abstract namespace, like in the module
+	std::memcpy( address.sun_path, path.data( ), path.size( ) );
+	if( path[0] == '@' )
+		address.sun_path[0] = '\0';
+
+	socket_fd = socket( AF_UNIX, SOCK_SEQPACKET, 0 );
+	if( socket_fd == -1 )
+		return false;
+
+	const socklen_t length = static_cast<socklen_t>( offsetof( sockaddr_un, sun_path ) + path.size( ) );
+	if( connect( socket_fd, reinterpret_cast<sockaddr *>( &address ), length ) == -1 )
+	{
+		close( socket_fd );
+		socket_fd = -1;
+		return false;
+	}
+
+	MultiLibrary::ByteBuffer hello;
+	EncodeFrameHeader( hello, 0, 0 );
+	EncodeHelloRecord( hello, hello_record );
+	const size_t size = static_cast<size_t>( hello.Size( ) );
+	hello.Seek( 0 );
+	EncodeFrameHeader( hello, 0, static_cast<uint32_t>( size - frame_header_size ) );
+	if( send( socket_fd, hello.GetBuffer( ), size, MSG_NOSIGNAL ) != static_cast<ssize_t>( size ) )
+	{
+		close( socket_fd );
+		socket_fd = -1;
+		return false;
+	}
+
+	reader_thread = std::thread( &FakeClient::ReaderThread, this );
+	return true;
+}
+
+void FakeClient::Join( )
+{
+	if( reader_thread.joinable( ) )
+		reader_thread.join( );
+
+	if( socket_fd != -1 )
+	{
+		close( socket_fd );
+		socket_fd = -1;
+	}
+}
+
+uint64_t FakeClient::GetRecords( ) const
+{
+	return records.load( std::memory_order_relaxed );
+}
+
+uint64_t FakeClient::GetLost( ) const
+{
+	return lost.load( std::memory_order_relaxed );
+}
+
+uint64_t FakeClient::GetFrames( ) const
+{
+	return frames.load( std::memory_order_relaxed );
+}
+
+uint64_t FakeClient::GetErrors( ) const
+{
+	return errors.load( std::memory_order_relaxed );
+}
+
+int FakeClient::GetDelay( ) const
+{
+	return read_delay;
+}
+
+const Histogram &FakeClient::GetLatency( ) const
+{
+	return latency;
+}
+
+void FakeClient::ReaderThread( )
+{
+	std::vector<uint8_t> buffer( max_frame_size );
+	while( true )
+	{
+		const ssize_t received = recv( socket_fd, buffer.data( ), buffer.size( ), 0 );
+		if( received <= 0 )
+			break;
+
+		frames.fetch_add( 1, std::memory_order_relaxed );
+		Process( buffer.data( ), static_cast<size_t>( received ) );
+		if( read_delay > 0 )
+			std::this_thread::sleep_for( std::chrono::microseconds( read_delay ) );
+	}
+}
+
+void FakeClient::Process( const uint8_t *data, size_t size )
+{
+	const uint64_t now = MonotonicNanoseconds( );
+	MultiLibrary::MemoryBuffer stream( const_cast<uint8_t *>( data ), size );
+	FrameHeader frame_header;
+	MultiLibrary::ByteBuffer frame;
+	if( !DecodeFrame( stream, frame_header, frame, max_frame_size ) )
+	{
+		errors.fetch_add( 1, std::memory_order_relaxed );
+		return;
+	}
+
+	if( frame.Size( ) == 0 )
+		return;
+
+	// records are read in place, messages are never copied
+	BufferView view( frame.GetBuffer( ), static_cast<size_t>( frame.Size( ) ) );
+	SpewState state;
+	RecordHeader record_header;
+	SpewRecordView spew;
+	uint64_t gap = 0;
+	while( view.Remaining( ) != 0 && DecodeRecordHeader( view, record_header ) )
+	{
+		bool valid = true;
+		if( record_header.kind == RECORD_SPEW )
+		{
+			valid = DecodeSpewRecord( view, record_header, state, spew );
+			if( valid )
+			{
+				records.fetch_add( 1, std::memory_order_relaxed );
+				latency.Add( now > spew.time ? now - spew.time : 0 );
+			}
+		}
+		else if( record_header.kind == RECORD_GAP )
+		{
+			valid = DecodeGapRecord( view, record_header, gap );
+			if( valid )
+				lost.fetch_add( gap, std::memory_order_relaxed );
+		}
+		else
+			valid = SkipRecord( view, record_header );
+
+		if( !valid )
+		{
+			errors.fetch_add( 1, std::memory_order_relaxed );
+			return;
+		}
+	}
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Protocol.hpp>
+#include <Stats.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace xconsole
+{
+
+/*!
+ \brief Console that connects to the module and measures what it receives.
+
+ Reads as fast as it can, or pauses after every frame to play a slow
+ console, and records how long records took from capture to arrival.
+ */
+class FakeClient
+{
+public:
+	/*!
+	 \brief Create a console.
+
+	 \param delay Microseconds to pause after every frame, 0 to never pause.
+	 \param hello Hello record to send after connecting.
+	 */
+	FakeClient( int delay, const HelloRecord &hello );
+	~FakeClient( );
+
+	/*!
+	 \brief Connect and start reading in a separate thread.
+
+	 \param path Address the module listens on, starting with @ for the
+	 abstract namespace.
+
+	 \return true if it succeeds, false if it fails.
+	 */
+	bool Start( const std::string &path );
+
+	/*!
+	 \brief Wait for the module to close the connection.
+	 */
+	void Join( );
+
+	/*!
+	 \brief Return the amount of spew records received.
+
+	 \return Amount of spew records.
+	 */
+	uint64_t GetRecords( ) const;
+
+	/*!
+	 \brief Return the amount of records reported lost by gap records.
+
+	 \return Amount of lost records.
+	 */
+	uint64_t GetLost( ) const;
+
+	/*!
+	 \brief Return the amount of frames received.
+
+	 \return Amount of frames.
+	 */
+	uint64_t GetFrames( ) const;
+
+	/*!
+	 \brief Return the amount of frames that couldn't be decoded.
+
+	 \return Amount of bad frames.
+	 */
+	uint64_t GetErrors( ) const;
+
+	/*!
+	 \brief Return the delay between reads.
+
+	 \return Microseconds paused after every frame.
+	 */
+	int GetDelay( ) const;
+
+	/*!
+	 \brief Return how long records took from capture to arrival.
+
+	 \return Histogram of latencies, in nanoseconds.
+	 */
+	const Histogram &GetLatency( ) const;
+
+private:
+	void ReaderThread( );
+	void Process( const uint8_t *data, size_t size );
+
+	int read_delay;
+	HelloRecord hello_record;
+	int socket_fd;
+	std::thread reader_thread;
+	std::atomic<uint64_t> records;
+	std::atomic<uint64_t> lost;
+	std::atomic<uint64_t> frames;
+	std::atomic<uint64_t> errors;
+	Histogram latency;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,324 @@
+#include <FakeClient.hpp>
+#include <Stats.hpp>
+#include <GarrysMod/Lua/Interface.h>
+#include <dbg.h>
+#include <tier0/icommandline.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ Headless load harness. Loads the module exactly like the game would, spews
+ synthetic output through the real hook from several threads, and connects
+ consoles that read at different speeds. Every -xconsole_* parameter is
+ passed through to the module.
+
+ --threads <count>           spewing threads (default 4)
+ --rate <records/s>          records per second per thread, 0 is unlimited (default 0)
+ --duration <ms>             how long to spew for (default 2000)
+ --size <min>[:<max>]        message size in bytes (default 16:160)
+ --client <delay>[:<policy>] console pausing <delay> microseconds per frame (repeatable)
+ --compress                  consoles ask for compression
+ --drain <ms>                how long to wait for consoles after spewing (default 500)
+ */
+
+struct Options
+{
+	int threads = 4;
+	int rate = 0;
+	int duration = 2000;
+	size_t min_size = 16;
+	size_t max_size = 160;
+	int drain = 500;
+	bool compress = false;
+	std::vector<std::pair<int, int>> clients;
+};
+
+struct ProducerResult
+{
+	uint64_t records = 0;
+	double seconds = 0.0;
+};
+
+static const char *group_names[] = {
+	"developer",
+	"console",
+	"engine",
+	"networking",
+	"lua"
+};
+
+static const char *policy_names[xconsole::POLICY_COUNT] = {
+	"drop_newest",
+	"drop_oldest",
+	"block",
+	"sample"
+};
+
+static int ParsePolicy( const char *name )
+{
+	for( int k = 0; k < xconsole::POLICY_COUNT; ++k )
+		if( std::strcmp( name, policy_names[k] ) == 0 )
+			return k;
+
+	return -1;
+}
+
+static bool ParseOptions( int argc, char **argv, Options &options )
+{
+	for( int k = 1; k < argc; ++k )
+	{
+		const std::string arg = argv[k];
+		const bool has_value = k + 1 < argc;
+		if( arg == "--threads" && has_value )
+			options.threads = std::atoi( argv[++k] );
+		else if( arg == "--rate" && has_value )
+			options.rate = std::atoi( argv[++k] );
+		else if( arg == "--duration" && has_value )
+			options.duration = std::atoi( argv[++k] );
+		else if( arg == "--drain" && has_value )
+			options.drain = std::atoi( argv[++k] );
+		else if( arg == "--compress" )
+			options.compress = true;
+		else if( arg == "--size" && has_value )
+		{
+			const std::string value = argv[++k];
+			const size_t colon = value.find( ':' );
+			options.min_size = std::strtoul( value.c_str( ), nullptr, 10 );
+			options.max_size = colon != std::string::npos ?
+				std::strtoul( value.c_str( ) + colon + 1, nullptr, 10 ) : options.min_size;
+			if( options.max_size < options.min_size )
+				return false;
+		}
+		else if( arg == "--client" && has_value )
+		{
+			const std::string value = argv[++k];
+			const size_t colon = value.find( ':' );
+			int policy = -1;
+			if( colon != std::string::npos )
+			{
+				policy = ParsePolicy( value.c_str( ) + colon + 1 );
+				if( policy == -1 )
+					return false;
+			}
+
+			options.clients.emplace_back( std::atoi( value.c_str( ) ), policy );
+		}
+		else if( arg.compare( 0, 2, "--" ) == 0 )
+			return false;
+		else if( arg.compare( 0, 10, "-xconsole_" ) == 0 )
+		{
+			// values can be negative, so anything that isn't another option is one
+			if( has_value && std::strncmp( argv[k + 1], "--", 2 ) != 0 &&
+				std::strncmp( argv[k + 1], "-xconsole_", 10 ) != 0 )
+				++k;
+		}
+		else if( arg[0] == '-' )
+			return false;
+	}
+
+	return options.threads > 0 && options.duration > 0 && options.rate >= 0;
+}
+
+static void ProducerThread(
+	const Options &options,
+	unsigned int seed,
+	std::atomic<bool> &running,
+	xconsole::Histogram &latency,
+	ProducerResult &result
+)
+{
+	typedef std::chrono::steady_clock clock;
+
+	std::mt19937 random( seed );
+	std::uniform_int_distribution<size_t> size_distribution( options.min_size, options.max_size );
+	std::uniform_int_distribution<size_t> group_distribution( 0, sizeof( group_names ) / sizeof( *group_names ) - 1 );
+	std::uniform_int_distribution<int> type_distribution( SPEW_MESSAGE, SPEW_LOG );
+
+	// messages are prepared up front, so only the hook is measured
+	std::vector<std::string> messages( 64 );
+	for( std::string &message : messages )
+	{
+		message.assign( size_distribution( random ), 'x' );
+		for( char &c : message )
+			c = static_cast<char>( 'a' + random( ) % 26 );
+
+		if( !message.empty( ) )
+			message.back( ) = '\n';
+	}
+
+	const Color color( 255, 255, 255, 255 );
+	const clock::time_point start = clock::now( );
+	const std::chrono::nanoseconds interval( options.rate > 0 ? 1000000000 / options.rate : 0 );
+	clock::time_point next = start;
+	uint64_t records = 0;
+	while( running.load( std::memory_order_relaxed ) )
+	{
+		if( options.rate > 0 )
+		{
+			next += interval;
+			std::this_thread::sleep_until( next );
+		}
+
+		const std::string &message = messages[records % messages.size( )];
+		const clock::time_point before = clock::now( );
+		ShimSpew(
+			static_cast<SpewType_t>( type_distribution( random ) ),
+			group_names[group_distribution( random )],
+			static_cast<int>( records % 3 ),
+			color,
+			message.c_str( )
+		);
+		latency.Add( static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>( clock::now( ) - before ).count( )
+		) );
+		++records;
+	}
+
+	result.records = records;
+	result.seconds = std::chrono::duration<double>( clock::now( ) - start ).count( );
+}
+
+static uint64_t Percentile( const xconsole::Histogram &histogram, double fraction )
+{
+	uint64_t total = 0;
+	for( size_t k = 0; k < xconsole::Histogram::bucket_count; ++k )
+		total += histogram.GetBucket( k );
+
+	// buckets are powers of two, so this is the limit of the right bucket
+	uint64_t count = 0;
+	for( size_t k = 0; k < xconsole::Histogram::bucket_count; ++k )
+	{
+		count += histogram.GetBucket( k );
+		if( total != 0 && static_cast<double>( count ) >= static_cast<double>( total ) * fraction )
+			return uint64_t( 1 ) << k;
+	}
+
+	return 0;
+}
+
+static void PrintLatency( const xconsole::Histogram &histogram )
+{
+	std::printf(
+		"{\"p50\":%llu,\"p99\":%llu,\"p999\":%llu,\"max\":%llu}",
+		static_cast<unsigned long long>( Percentile( histogram, 0.5 ) ),
+		static_cast<unsigned long long>( Percentile( histogram, 0.99 ) ),
+		static_cast<unsigned long long>( Percentile( histogram, 0.999 ) ),
+		static_cast<unsigned long long>( Percentile( histogram, 1.0 ) )
+	);
+}
+
+int main( int argc, char **argv )
+{
+	Options options;
+	if( !ParseOptions( argc, argv, options ) )
+	{
+		std::fprintf(
+			stderr,
+			"usage: %s [--threads <count>] [--rate <records/s>] [--duration <ms>] "
+			"[--size <min>[:<max>]] [--client <delay>[:<policy>]]... [--compress] "
+			"[--drain <ms>] [-xconsole_* parameters]\n",
+			argv[0]
+		);
+		return 1;
+	}
+
+	CommandLine( )->CreateCmdLine( argc, argv );
+
+	GarrysMod::Lua::ILuaBase lua_base;
+	GarrysMod::Lua::lua_State lua_state = { &lua_base };
+	gmod13_open( &lua_state );
+
+	const std::string path = CommandLine( )->ParmValue( "-xconsole_path", "@garrysmod_console" );
+	std::vector<std::unique_ptr<xconsole::FakeClient>> clients;
+	for( const std::pair<int, int> &client : options.clients )
+	{
+		xconsole::HelloRecord hello;
+		hello.features = options.compress ? xconsole::FEATURE_COMPRESSION : 0;
+		if( client.second != -1 )
+		{
+			hello.has_policy = true;
+			hello.policy = static_cast<uint8_t>( client.second );
+		}
+
+		clients.emplace_back( new xconsole::FakeClient( client.first, hello ) );
+		if( !clients.back( )->Start( path ) )
+		{
+			std::fprintf( stderr, "failed to connect to %s\n", path.c_str( ) );
+			gmod13_close( &lua_state );
+			return 1;
+		}
+	}
+
+	// give the module a moment to register the consoles and their hellos
+	std::this_thread::sleep_for( std::chrono::milliseconds( 50 ) );
+
+	std::atomic<bool> running( true );
+	xconsole::Histogram hook_latency;
+	std::vector<ProducerResult> results( static_cast<size_t>( options.threads ) );
+	std::vector<std::thread> producers;
+	for( int k = 0; k < options.threads; ++k )
+		producers.emplace_back(
+			ProducerThread,
+			std::cref( options ),
+			static_cast<unsigned int>( k + 1 ),
+			std::ref( running ),
+			std::ref( hook_latency ),
+			std::ref( results[static_cast<size_t>( k )] )
+		);
+
+	std::this_thread::sleep_for( std::chrono::milliseconds( options.duration ) );
+	running.store( false, std::memory_order_relaxed );
+	for( std::thread &producer : producers )
+		producer.join( );
+
+	std::this_thread::sleep_for( std::chrono::milliseconds( options.drain ) );
+	gmod13_close( &lua_state );
+	for( std::unique_ptr<xconsole::FakeClient> &client : clients )
+		client->Join( );
+
+	uint64_t records = 0;
+	double seconds = 0.0;
+	for( const ProducerResult &result : results )
+	{
+		records += result.records;
+		if( result.seconds > seconds )
+			seconds = result.seconds;
+	}
+
+	std::printf(
+		"{\"producer\":{\"threads\":%d,\"records\":%llu,\"seconds\":%.6f,\"records_per_second\":%.1f,\"hook_ns\":",
+		options.threads,
+		static_cast<unsigned long long>( records ),
+		seconds,
+		seconds > 0.0 ? static_cast<double>( records ) / seconds : 0.0
+	);
+	PrintLatency( hook_latency );
+	std::printf( "},\"clients\":[" );
+	for( size_t k = 0; k < clients.size( ); ++k )
+	{
+		const xconsole::FakeClient &client = *clients[k];
+		std::printf(
+			"%s{\"delay_us\":%d,\"frames\":%llu,\"records\":%llu,\"lost\":%llu,\"errors\":%llu,\"latency_ns\":",
+			k != 0 ? "," : "",
+			client.GetDelay( ),
+			static_cast<unsigned long long>( client.GetFrames( ) ),
+			static_cast<unsigned long long>( client.GetRecords( ) ),
+			static_cast<unsigned long long>( client.GetLost( ) ),
+			static_cast<unsigned long long>( client.GetErrors( ) )
+		);
+		PrintLatency( client.GetLatency( ) );
+		std::printf( "}" );
+	}
+
+	std::printf( "]}\n" );
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+/*!
+ \brief Stand-in for the SDK's Color, which packs RGBA into an int.
+ */
+class Color
+{
+public:
+	Color( ) :
+		raw( 0 )
+	{ }
+
+	Color( int r, int g, int b, int a = 255 ) :
+		raw( ( r & 0xFF ) | ( g & 0xFF ) << 8 | ( b & 0xFF ) << 16 | ( a & 0xFF ) << 24 )
+	{ }
+
+	int GetRawColor( ) const
+	{
+		return raw;
+	}
+
+private:
+	int raw;
+};
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+
+/*
+ Stand-in for the Lua interface the module is loaded through. The harness
+ has no Lua state, so everything pushed is simply discarded.
+ */
+
+namespace GarrysMod
+{
+
+namespace Lua
+{
+
+enum
+{
+	SPECIAL_GLOB,
+	SPECIAL_ENV,
+	SPECIAL_REG
+};
+
+struct lua_State;
+
+typedef int ( *CFunc )( lua_State *L );
+
+class ILuaBase
+{
+public:
+	void ThrowError( const char *strError );
+	void CreateTable( ) { }
+	void SetField( int, const char * ) { }
+	void SetTable( int ) { }
+	void PushNumber( double ) { }
+	void PushNil( ) { }
+	void PushCFunction( CFunc ) { }
+	void PushSpecial( int ) { }
+	void Pop( int = 1 ) { }
+};
+
+struct lua_State
+{
+	ILuaBase *luabase;
+};
+
+} // namespace Lua
+
+} // namespace GarrysMod
+
+#define GMOD_MODULE_OPEN( ) \
+	static int gmod13_open__Imp( GarrysMod::Lua::ILuaBase *LUA ); \
+	extern "C" int gmod13_open( GarrysMod::Lua::lua_State *L ) \
+	{ \
+		return gmod13_open__Imp( L->luabase ); \
+	} \
+	static int gmod13_open__Imp( GarrysMod::Lua::ILuaBase *LUA )
+
+#define GMOD_MODULE_CLOSE( ) \
+	static int gmod13_close__Imp( GarrysMod::Lua::ILuaBase *LUA ); \
+	extern "C" int gmod13_close( GarrysMod::Lua::lua_State *L ) \
+	{ \
+		return gmod13_close__Imp( L->luabase ); \
+	} \
+	static int gmod13_close__Imp( GarrysMod::Lua::ILuaBase *LUA )
+
+#define LUA_FUNCTION_STATIC( FUNC ) \
+	static int FUNC##__Imp( GarrysMod::Lua::ILuaBase *LUA ); \
+	static int FUNC( GarrysMod::Lua::lua_State *L ) \
+	{ \
+		return FUNC##__Imp( L->luabase ); \
+	} \
+	static int FUNC##__Imp( GarrysMod::Lua::ILuaBase *LUA )
+
+extern "C" int gmod13_open( GarrysMod::Lua::lua_State *L );
+extern "C" int gmod13_close( GarrysMod::Lua::lua_State *L );
\ No newline at end of file
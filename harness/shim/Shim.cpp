@@ -0,0 +1,108 @@
+#include <GarrysMod/Lua/Interface.h>
+#include <dbg.h>
+#include <tier0/icommandline.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct SpewContext
+{
+	const char *group;
+	int level;
+	Color color;
+};
+
+static SpewRetval_t DefaultSpewFunc( SpewType_t, const char * )
+{
+	// the game would print here, which the harness doesn't want to measure
+	return SPEW_CONTINUE;
+}
+
+static SpewOutputFunc_t spew_function = DefaultSpewFunc;
+static thread_local SpewContext spew_context = { "", 0, Color( ) };
+static ICommandLine command_line;
+
+void SpewOutputFunc( SpewOutputFunc_t func )
+{
+	spew_function = func != nullptr ? func : DefaultSpewFunc;
+}
+
+SpewOutputFunc_t GetSpewOutputFunc( )
+{
+	return spew_function;
+}
+
+const char *GetSpewOutputGroup( )
+{
+	return spew_context.group;
+}
+
+int GetSpewOutputLevel( )
+{
+	return spew_context.level;
+}
+
+const Color *GetSpewOutputColor( )
+{
+	return &spew_context.color;
+}
+
+SpewRetval_t ShimSpew( SpewType_t type, const char *group, int level, const Color &color, const char *message )
+{
+	spew_context.group = group;
+	spew_context.level = level;
+	spew_context.color = color;
+	return spew_function( type, message );
+}
+
+void Warning( const char *format, ... )
+{
+	// unlike spew from the game, warnings are meant to be seen
+	va_list arguments;
+	va_start( arguments, format );
+	std::vfprintf( stderr, format, arguments );
+	va_end( arguments );
+}
+
+void ICommandLine::CreateCmdLine( int argc, char **argv )
+{
+	arguments.assign( argv, argv + argc );
+}
+
+const char *ICommandLine::ParmValue( const char *psz, const char *pDefaultVal ) const
+{
+	const int index = FindParm( psz );
+	if( index == 0 || static_cast<size_t>( index ) + 1 >= arguments.size( ) )
+		return pDefaultVal;
+
+	return arguments[index + 1].c_str( );
+}
+
+int ICommandLine::ParmValue( const char *psz, int nDefaultVal ) const
+{
+	const char *value = ParmValue( psz, static_cast<const char *>( nullptr ) );
+	return value != nullptr ? std::atoi( value ) : nDefaultVal;
+}
+
+int ICommandLine::FindParm( const char *psz ) const
+{
+	// like tier0, index 0 is the program and means the parameter is missing
+	for( size_t k = 1; k < arguments.size( ); ++k )
+		if( arguments[k] == psz )
+			return static_cast<int>( k );
+
+	return 0;
+}
+
+ICommandLine *CommandLine( )
+{
+	return &command_line;
+}
+
+void GarrysMod::Lua::ILuaBase::ThrowError( const char *strError )
+{
+	// Lua would unwind to whoever loaded the module, which is the harness
+	std::fprintf( stderr, "module error: %s\n", strError );
+	std::exit( EXIT_FAILURE );
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Color.h>
+
+/*
+ Stand-in for the parts of tier0's spew API the module uses, so the real
+ hook can run outside of the game. Messages go through whichever spew
+ function is installed, with their group, level and color available to it
+ through the getters, exactly like tier0 does.
+ */
+
+enum SpewType_t
+{
+	SPEW_MESSAGE = 0,
+	SPEW_WARNING,
+	SPEW_ASSERT,
+	SPEW_ERROR,
+	SPEW_LOG,
+	SPEW_TYPE_COUNT
+};
+
+enum SpewRetval_t
+{
+	SPEW_DEBUGGER = 0,
+	SPEW_CONTINUE,
+	SPEW_ABORT
+};
+
+typedef SpewRetval_t ( *SpewOutputFunc_t )( SpewType_t spewType, const char *pMsg );
+
+void SpewOutputFunc( SpewOutputFunc_t func );
+SpewOutputFunc_t GetSpewOutputFunc( );
+const char *GetSpewOutputGroup( );
+int GetSpewOutputLevel( );
+const Color *GetSpewOutputColor( );
+
+/*!
+ \brief Spew a message through the installed spew function.
+
+ Safe to call from any thread, the group, level and color are per thread.
+
+ \param type Spew type.
+ \param group Spew group.
+ \param level Spew level.
+ \param color Spew color.
+ \param message Message text.
+
+ \return What the spew function returned.
+ */
+SpewRetval_t ShimSpew( SpewType_t type, const char *group, int level, const Color &color, const char *message );
+
+/*!
+ \brief Print a warning, like tier0 does to the game console.
+
+ \param format printf style format.
+ */
+void Warning( const char *format, ... );
\ No newline at end of file
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+/*!
+ \brief Stand-in for tier0's command line, filled by the harness.
+ */
+class ICommandLine
+{
+public:
+	void CreateCmdLine( int argc, char **argv );
+
+	const char *ParmValue( const char *psz, const char *pDefaultVal = nullptr ) const;
+	int ParmValue( const char *psz, int nDefaultVal ) const;
+	int FindParm( const char *psz ) const;
+
+private:
+	std::vector<std::string> arguments;
+};
+
+ICommandLine *CommandLine( );
\ No newline at end of file
@@ -6,11 +6,76 @@ newoption({
 	value = "path to garrysmod_common directory"
 })
 
-include(assert(_OPTIONS.gmcommon or os.getenv("GARRYSMOD_COMMON"),
-	"you didn't provide a path to your garrysmod_common (https://github.com/danielga/garrysmod_common) directory"))
-
-CreateWorkspace({name = "xconsole"})
-	CreateProject({serverside = true})
-		warnings("Default")
-		IncludeSDKCommon()
-		IncludeSDKTier0()
+newoption({
+	trigger = "benchmark",
+	description = "Generates the serialization benchmark only, which needs neither garrysmod_common nor the SDK"
+})
+
+newoption({
+	trigger = "harness",
+	description = "Generates the headless load harness (Linux only), which needs neither garrysmod_common nor the SDK"
+})
+
+if _OPTIONS.benchmark or _OPTIONS.harness then
+	workspace("xconsole_tools")
+		configurations({"Release", "Debug"})
+		location("projects/" .. os.target() .. "/" .. _ACTION)
+		language("C++")
+		cppdialect("C++11")
+
+		filter("configurations:Release")
+			optimize("Speed")
+			defines({"NDEBUG"})
+
+		filter("configurations:Debug")
+			symbols("On")
+
+		filter({})
+
+	if _OPTIONS.benchmark then
+	project("benchmark")
+		kind("ConsoleApp")
+		targetdir("projects/" .. os.target() .. "/" .. _ACTION .. "/bin/%{cfg.buildcfg}")
+		includedirs({"benchmark", "source"})
+		files({
+			"benchmark/*.cpp",
+			"benchmark/*.hpp",
+			"source/ByteBuffer.cpp",
+			"source/IOStream.cpp",
+			"source/InputStream.cpp",
+			"source/Lz4.cpp",
+			"source/MemoryBuffer.cpp",
+			"source/OutputStream.cpp",
+			"source/Protocol.cpp",
+			"source/SegmentedBuffer.cpp",
+			"source/Stream.cpp"
+		})
+	end
+
+	if _OPTIONS.harness then
+	project("harness")
+		kind("ConsoleApp")
+		targetdir("projects/" .. os.target() .. "/" .. _ACTION .. "/bin/%{cfg.buildcfg}")
+		includedirs({"harness/shim", "harness", "source"})
+		files({
+			"harness/**.cpp",
+			"harness/**.hpp",
+			"harness/**.h",
+			"source/*.cpp",
+			"source/*.hpp"
+		})
+		links({"pthread", "rt"})
+	end
+else
+	include(assert(_OPTIONS.gmcommon or os.getenv("GARRYSMOD_COMMON"),
+		"you didn't provide a path to your garrysmod_common (https://github.com/danielga/garrysmod_common) directory"))
+
+	CreateWorkspace({name = "xconsole"})
+		CreateProject({serverside = true})
+			warnings("Default")
+			IncludeSDKCommon()
+			IncludeSDKTier0()
+
+			filter("system:linux")
+				links("rt")
+end
\ No newline at end of file
@@ -0,0 +1,282 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace xconsole
+{
+
+/*!
+ \brief Non-owning reference to a string, which isn't NUL terminated.
+
+ Only valid while the memory it refers to is.
+ */
+struct StringView
+{
+	StringView( ) :
+		data( nullptr ),
+		size( 0 )
+	{ }
+
+	StringView( const char *string, size_t length ) :
+		data( string ),
+		size( length )
+	{ }
+
+	bool empty( ) const
+	{
+		return size == 0;
+	}
+
+	std::string ToString( ) const
+	{
+		return std::string( data, size );
+	}
+
+	bool operator==( const StringView &other ) const
+	{
+		return size == other.size && ( size == 0 || std::memcmp( data, other.data, size ) == 0 );
+	}
+
+	bool operator!=( const StringView &other ) const
+	{
+		return !( *this == other );
+	}
+
+	const char *data;
+	size_t size;
+};
+
+/*!
+ \brief Non-owning reader of a span of bytes.
+
+ Reads the same layout as InputStream, but without virtual calls, and hands
+ out strings and blobs as references into the span instead of copying them.
+ Works over any memory, like mapped files, received packets or shared
+ memory, which must outlive the view and anything read from it.
+
+ Reads past the end fail without consuming anything, after which the view
+ is no longer valid.
+ */
+class BufferView
+{
+public:
+	BufferView( ) :
+		view_data( nullptr ),
+		view_size( 0 ),
+		view_offset( 0 ),
+		valid( true )
+	{ }
+
+	/*!
+	 \brief Create a view of a span of bytes.
+
+	 \param data Start of the span.
+	 \param size Size of the span.
+	 */
+	BufferView( const void *data, size_t size ) :
+		view_data( static_cast<const uint8_t *>( data ) ),
+		view_size( size ),
+		view_offset( 0 ),
+		valid( true )
+	{ }
+
+	/*!
+	 \brief Tell if every read so far succeeded.
+
+	 \return false if a read went past the end, true otherwise.
+	 */
+	bool IsValid( ) const
+	{
+		return valid;
+	}
+
+	/*!
+	 \brief Return the current position on the view.
+
+	 \return Position of the next read.
+	 */
+	size_t Tell( ) const
+	{
+		return view_offset;
+	}
+
+	/*!
+	 \brief Return the size of the view.
+
+	 \return Size of the span.
+	 */
+	size_t Size( ) const
+	{
+		return view_size;
+	}
+
+	/*!
+	 \brief Return the amount of unread bytes.
+
+	 \return Bytes left after the current position.
+	 */
+	size_t Remaining( ) const
+	{
+		return view_size - view_offset;
+	}
+
+	/*!
+	 \brief Return the unread bytes.
+
+	 \return Pointer to the current position.
+	 */
+	const uint8_t *Data( ) const
+	{
+		return view_data + view_offset;
+	}
+
+	/*!
+	 \brief Set the current position.
+
+	 \param position Position to move to, up to the size of the view.
+
+	 \return false if the position is past the end, true otherwise.
+	 */
+	bool Seek( size_t position )
+	{
+		if( position > view_size )
+			return Fail( );
+
+		view_offset = position;
+		return true;
+	}
+
+	/*!
+	 \brief Move past the specified amount of bytes.
+
+	 \param size Amount of bytes to skip.
+
+	 \return false if there aren't enough bytes, true otherwise.
+	 */
+	bool Skip( size_t size )
+	{
+		if( Remaining( ) < size )
+			return Fail( );
+
+		view_offset += size;
+		return true;
+	}
+
+	/*!
+	 \brief Read a blob of the specified size, without copying it.
+
+	 \param size Size of the blob.
+	 \param data Where to store the start of the blob.
+
+	 \return false if there aren't enough bytes, true otherwise.
+	 */
+	bool ReadBytes( size_t size, const uint8_t *&data )
+	{
+		if( Remaining( ) < size )
+			return Fail( );
+
+		data = view_data + view_offset;
+		view_offset += size;
+		return true;
+	}
+
+	/*!
+	 \brief Read a string of the specified length, without copying it.
+
+	 \param length Length of the string.
+	 \param data Where to store the string.
+
+	 \return false if there aren't enough bytes, true otherwise.
+	 */
+	bool ReadString( size_t length, StringView &data )
+	{
+		const uint8_t *bytes = nullptr;
+		if( !ReadBytes( length, bytes ) )
+			return false;
+
+		data = StringView( reinterpret_cast<const char *>( bytes ), length );
+		return true;
+	}
+
+	/*!
+	 \brief Read a NUL terminated string, without copying it.
+
+	 The terminator is consumed but not part of the string.
+
+	 \param data Where to store the string.
+
+	 \return false if there's no terminator, true otherwise.
+	 */
+	bool ReadString( StringView &data )
+	{
+		const void *terminator = Remaining( ) != 0 ? std::memchr( Data( ), '\0', Remaining( ) ) : nullptr;
+		if( terminator == nullptr )
+			return Fail( );
+
+		const size_t length = static_cast<size_t>( static_cast<const uint8_t *>( terminator ) - Data( ) );
+		data = StringView( reinterpret_cast<const char *>( Data( ) ), length );
+		view_offset += length + 1;
+		return true;
+	}
+
+	/*!
+	 \brief Read a view of the specified amount of bytes and move past them.
+
+	 \param size Size of the new view.
+	 \param data Where to store the new view.
+
+	 \return false if there aren't enough bytes, true otherwise.
+	 */
+	bool ReadView( size_t size, BufferView &data )
+	{
+		const uint8_t *bytes = nullptr;
+		if( !ReadBytes( size, bytes ) )
+			return false;
+
+		data = BufferView( bytes, size );
+		return true;
+	}
+
+	/*!
+	 \brief Read an arithmetic value, with the same layout as InputStream.
+
+	 The value is left untouched if there aren't enough bytes.
+
+	 \param data Where to store the value.
+
+	 \return This object.
+	 */
+	template<typename Value>
+	BufferView &operator>>( Value &data )
+	{
+		static_assert( std::is_arithmetic<Value>::value, "only arithmetic values can be read" );
+
+		if( Remaining( ) < sizeof( Value ) )
+		{
+			Fail( );
+			return *this;
+		}
+
+		std::memcpy( &data, view_data + view_offset, sizeof( Value ) );
+		view_offset += sizeof( Value );
+		return *this;
+	}
+
+private:
+	bool Fail( )
+	{
+		valid = false;
+		return false;
+	}
+
+	const uint8_t *view_data;
+	size_t view_size;
+	size_t view_offset;
+	bool valid;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -44,19 +44,22 @@ namespace MultiLibrary
 
 ByteBuffer::ByteBuffer( ) :
 	end_of_file( true ),
-	buffer_offset( 0 )
+	buffer_offset( 0 ),
+	prepared_size( 0 )
 { }
 
 ByteBuffer::ByteBuffer( size_t size ) :
 	end_of_file( true ),
-	buffer_offset( 0 )
+	buffer_offset( 0 ),
+	prepared_size( 0 )
 {
 	Resize( size );
 }
 
 ByteBuffer::ByteBuffer( const uint8_t *copy_buffer, size_t size ) :
 	end_of_file( true ),
-	buffer_offset( 0 )
+	buffer_offset( 0 ),
+	prepared_size( 0 )
 {
 	Assign( copy_buffer, size );
 }
@@ -159,7 +162,7 @@ void ByteBuffer::Resize( size_t size )
 
 void ByteBuffer::ShrinkToFit( )
 {
-	std::vector<uint8_t>( buffer_internal ).swap( buffer_internal );
+	Storage( buffer_internal ).swap( buffer_internal );
 }
 
 void ByteBuffer::Assign( const uint8_t *copy_buffer, size_t size )
@@ -192,6 +195,18 @@ size_t ByteBuffer::Read( void *value, size_t size )
 	return clamped;
 }
 
+const uint8_t *ByteBuffer::Peek( size_t &size ) const
+{
+	if( buffer_offset >= buffer_internal.size( ) )
+	{
+		size = 0;
+		return buffer_internal.data( );
+	}
+
+	size = buffer_internal.size( ) - buffer_offset;
+	return &buffer_internal[buffer_offset];
+}
+
 size_t ByteBuffer::Write( const void *value, size_t size )
 {
 	assert( value != nullptr && size != 0 );
@@ -204,4 +219,49 @@ size_t ByteBuffer::Write( const void *value, size_t size )
 	return size;
 }
 
+size_t ByteBuffer::WriteV( const IoVector *vectors, size_t count )
+{
+	assert( vectors != nullptr || count == 0 );
+
+	size_t size = 0;
+	for( size_t k = 0; k < count; ++k )
+		size += vectors[k].size;
+
+	if( size == 0 )
+		return 0;
+
+	uint8_t *data = Prepare( size );
+	for( size_t k = 0; k < count; ++k )
+	{
+		if( vectors[k].size == 0 )
+			continue;
+
+		std::memcpy( data, vectors[k].data, vectors[k].size );
+		data += vectors[k].size;
+	}
+
+	Commit( size );
+	return size;
+}
+
+uint8_t *ByteBuffer::Prepare( size_t size )
+{
+	assert( size != 0 );
+
+	prepared_size = buffer_internal.size( );
+	if( prepared_size < buffer_offset + size )
+		Resize( buffer_offset + size );
+
+	return &buffer_internal[buffer_offset];
+}
+
+void ByteBuffer::Commit( size_t size )
+{
+	assert( buffer_offset + size <= buffer_internal.size( ) );
+
+	buffer_offset += size;
+	Resize( prepared_size > buffer_offset ? prepared_size : buffer_offset );
+	prepared_size = buffer_internal.size( );
+}
+
 } // namespace MultiLibrary
\ No newline at end of file
@@ -37,12 +37,52 @@
 #pragma once
 
 #include <IOStream.hpp>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include <set>
 
 namespace MultiLibrary
 {
+
+/*!
+ \brief An allocator that leaves new elements uninitialized.
+
+ Elements added without a value (like when resizing a vector) are default
+ initialized instead of value initialized, which for bytes means the
+ memory isn't cleared only to be overwritten right after.
+ */
+template<typename T>
+class UninitializedAllocator : public std::allocator<T>
+{
+public:
+	template<typename U>
+	struct rebind
+	{
+		typedef UninitializedAllocator<U> other;
+	};
+
+	UninitializedAllocator( )
+	{ }
+
+	template<typename U>
+	UninitializedAllocator( const UninitializedAllocator<U> & )
+	{ }
+
+	template<typename U>
+	void construct( U *pointer )
+	{
+		::new( static_cast<void *>( pointer ) ) U;
+	}
+
+	template<typename U, typename... Args>
+	void construct( U *pointer, Args &&... args )
+	{
+		::new( static_cast<void *>( pointer ) ) U( std::forward<Args>( args )... );
+	}
+};
+
 /*!
  \brief A class that represents a buffer composed by bytes.
 
@@ -205,6 +245,8 @@ public:
 	/*!
 	 \brief Resize the internal buffer.
 
+	 Bytes added by growing the buffer are left uninitialized.
+
 	 \param size New size of the internal buffer.
 	 */
 	void Resize( size_t size );
@@ -235,6 +277,15 @@ public:
 	 */
 	size_t Read( void *value, size_t size );
 
+	/*!
+	 \brief Return the unread data of the buffer.
+
+	 \param size Where to store the amount of unread bytes.
+
+	 \return Pointer to the unread data.
+	 */
+	const uint8_t *Peek( size_t &size ) const;
+
 	/*!
 	 \brief Write data to the buffer.
 
@@ -245,10 +296,51 @@ public:
 	 */
 	size_t Write( const void *value, size_t size );
 
+	/*!
+	 \brief Write several pieces of data to the buffer, growing it once.
+
+	 \param vectors Pieces to write.
+	 \param count Amount of pieces.
+
+	 \return Size in bytes of the written data.
+	 */
+	size_t WriteV( const IoVector *vectors, size_t count );
+
+	/*!
+	 \brief Make room to write in place at the current position.
+
+	 The returned memory is uninitialized and can be written to directly
+	 (by an encoder, a compressor, a read from a socket, etc), after which
+	 Commit says how much of it was used. Nothing else should be done with
+	 the buffer in between.
+
+	 \param size Amount of bytes to make room for.
+
+	 \return Pointer to at least size writable bytes.
+
+	 \sa Commit
+	 */
+	uint8_t *Prepare( size_t size );
+
+	/*!
+	 \brief Keep bytes written to the memory returned by Prepare.
+
+	 The position moves past them and the size grows to include them,
+	 anything prepared but not committed is discarded.
+
+	 \param size Amount of bytes written, up to the prepared amount.
+
+	 \sa Prepare
+	 */
+	void Commit( size_t size );
+
 private:
+	typedef std::vector<uint8_t, UninitializedAllocator<uint8_t>> Storage;
+
 	bool end_of_file;
-	std::vector<uint8_t> buffer_internal;
+	Storage buffer_internal;
 	size_t buffer_offset;
+	size_t prepared_size;
 };
 
 } // namespace MultiLibrary
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include <Channel.hpp>
+
+namespace xconsole
+{
+
+Channel::Channel( Filter *filter, size_t reserve ) :
+	channel_filter( filter ),
+	subscribers( 0 ),
+	batch_records( 0 ),
+	batch_lost( 0 )
+{
+	batch.Reserve( reserve );
+}
+
+Filter *Channel::GetFilter( ) const
+{
+	return channel_filter.get( );
+}
+
+bool Channel::Matches( int32_t type, int32_t level, uint32_t group, const char *message, size_t length )
+{
+	return !channel_filter || channel_filter->Matches( type, level, group, message, length );
+}
+
+void Channel::AddSubscriber( )
+{
+	++subscribers;
+}
+
+void Channel::RemoveSubscriber( )
+{
+	--subscribers;
+}
+
+size_t Channel::GetSubscribers( ) const
+{
+	return subscribers;
+}
+
+bool Channel::IsEmpty( ) const
+{
+	return batch.Size( ) == 0;
+}
+
+size_t Channel::GetSize( ) const
+{
+	return static_cast<size_t>( batch.Size( ) );
+}
+
+size_t Channel::GetRecords( ) const
+{
+	return batch_records;
+}
+
+uint32_t Channel::GetFrameRecords( ) const
+{
+	return static_cast<uint32_t>( batch_records + batch_lost );
+}
+
+std::chrono::steady_clock::time_point Channel::GetStart( ) const
+{
+	return batch_start;
+}
+
+void Channel::AppendGap( uint64_t records )
+{
+	Begin( );
+	BufferWriter writer( batch );
+	EncodeGapRecord( writer, records );
+	batch_lost += records;
+}
+
+void Channel::AppendSpew(
+	int32_t type,
+	int32_t level,
+	uint32_t group,
+	int32_t color,
+	uint64_t sequence,
+	uint64_t time,
+	const char *message,
+	size_t length
+)
+{
+	Begin( );
+	BufferWriter writer( batch );
+	EncodeSpewRecord( writer, batch_state, type, level, group, color, sequence, time, message, length );
+	++batch_records;
+}
+
+const uint8_t *Channel::Finish( size_t &size )
+{
+	size = static_cast<size_t>( batch.Size( ) );
+	batch.Seek( 0 );
+	EncodeFrameHeader( batch, 0, static_cast<uint32_t>( size - frame_header_size ) );
+	return batch.GetBuffer( );
+}
+
+void Channel::Clear( )
+{
+	batch.Clear( );
+	batch_records = 0;
+	batch_lost = 0;
+}
+
+void Channel::Begin( )
+{
+	if( !IsEmpty( ) )
+		return;
+
+	// the header is rewritten with the final length when finishing
+	EncodeFrameHeader( batch, 0, 0 );
+	batch_state.Reset( );
+	batch_start = std::chrono::steady_clock::now( );
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <ByteBuffer.hpp>
+#include <Filter.hpp>
+#include <Protocol.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace xconsole
+{
+
+/*!
+ \brief Frame being batched for the consoles that share a subscription.
+
+ Records are only encoded into channels whose filter lets them through, so
+ consoles with the same subscription share frames, and records nobody wants
+ are never encoded at all.
+ */
+class Channel
+{
+public:
+	/*!
+	 \brief Create a channel.
+
+	 \param filter Filter records must match, owned by the channel, or
+	 nullptr for a channel that receives everything.
+	 \param reserve Bytes to reserve for frames.
+	 */
+	Channel( Filter *filter, size_t reserve );
+
+	/*!
+	 \brief Return the filter of the channel.
+
+	 \return Filter or nullptr if the channel receives everything.
+	 */
+	Filter *GetFilter( ) const;
+
+	/*!
+	 \brief Tell if a record is let through.
+
+	 \param type Spew type.
+	 \param level Spew level.
+	 \param group Spew group identifier.
+	 \param message Message text.
+	 \param length Length of the message.
+
+	 \return true if the record matches, false otherwise.
+	 */
+	bool Matches( int32_t type, int32_t level, uint32_t group, const char *message, size_t length );
+
+	/*!
+	 \brief Count one more console using the channel.
+	 */
+	void AddSubscriber( );
+
+	/*!
+	 \brief Count one less console using the channel.
+	 */
+	void RemoveSubscriber( );
+
+	/*!
+	 \brief Return the amount of consoles using the channel.
+
+	 \return Amount of consoles.
+	 */
+	size_t GetSubscribers( ) const;
+
+	/*!
+	 \brief Tell if a frame is being batched.
+
+	 \return true if nothing was appended since the last frame, false otherwise.
+	 */
+	bool IsEmpty( ) const;
+
+	/*!
+	 \brief Return the size of the frame being batched.
+
+	 \return Size of the frame.
+	 */
+	size_t GetSize( ) const;
+
+	/*!
+	 \brief Return the amount of spew records in the frame being batched.
+
+	 \return Amount of spew records.
+	 */
+	size_t GetRecords( ) const;
+
+	/*!
+	 \brief Return the amount of records the frame reports, lost ones included.
+
+	 \return Amount of records.
+	 */
+	uint32_t GetFrameRecords( ) const;
+
+	/*!
+	 \brief Return when the frame being batched was started.
+
+	 \return Time the first record was appended.
+	 */
+	std::chrono::steady_clock::time_point GetStart( ) const;
+
+	/*!
+	 \brief Append a gap record to the frame.
+
+	 \param records Amount of records that were lost.
+	 */
+	void AppendGap( uint64_t records );
+
+	/*!
+	 \brief Append a spew record to the frame.
+
+	 \param type Spew type.
+	 \param level Spew level.
+	 \param group Spew group identifier.
+	 \param color Raw spew color.
+	 \param sequence Sequence number.
+	 \param time Monotonic capture time, in nanoseconds.
+	 \param message Message text.
+	 \param length Length of the message.
+	 */
+	void AppendSpew(
+		int32_t type,
+		int32_t level,
+		uint32_t group,
+		int32_t color,
+		uint64_t sequence,
+		uint64_t time,
+		const char *message,
+		size_t length
+	);
+
+	/*!
+	 \brief Complete the frame header.
+
+	 \param size Where to store the size of the frame.
+
+	 \return Frame data, valid until the next call to Clear.
+	 */
+	const uint8_t *Finish( size_t &size );
+
+	/*!
+	 \brief Start over with an empty frame.
+	 */
+	void Clear( );
+
+private:
+	void Begin( );
+
+	std::unique_ptr<Filter> channel_filter;
+	size_t subscribers;
+	MultiLibrary::ByteBuffer batch;
+	size_t batch_records;
+	uint64_t batch_lost;
+	SpewState batch_state;
+	std::chrono::steady_clock::time_point batch_start;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,359 @@
+#include <Client.hpp>
+#include <Clock.hpp>
+#include <MemoryBuffer.hpp>
+
+namespace xconsole
+{
+
+static const size_t gap_frame_size = frame_header_size + record_header_size + sizeof( uint64_t );
+
+ClientPolicy::ClientPolicy( ) :
+	policy( POLICY_DROP_NEWEST ),
+	budget( 4 * 1024 * 1024 ),
+	block_timeout( 100 ),
+	sample_rate( 10 )
+{ }
+
+ClientCounters::ClientCounters( ) :
+	frames( 0 ),
+	bytes( 0 ),
+	blocked_writes( 0 ),
+	write_errors( 0 )
+{ }
+
+Client::Client( Connection *connection, const ClientPolicy &policy, Histogram &write_latency ) :
+	client_connection( connection ),
+	client_policy( policy ),
+	queued_bytes( 0 ),
+	blocked( false ),
+	pending_gap( 0 ),
+	dropped( 0 ),
+	write_histogram( write_latency ),
+	sample_counter( 0 ),
+	known_groups( 0 ),
+	enabled_features( 0 ),
+	client_channel( nullptr )
+{ }
+
+Connection *Client::GetConnection( ) const
+{
+	return client_connection;
+}
+
+bool Client::Send(
+	const uint8_t *data,
+	size_t size,
+	uint32_t records,
+	FramePtr &frame,
+	bool essential
+)
+{
+	if( frames.empty( ) && !blocked )
+	{
+		switch( WriteFrame( data, size, pending_gap ) )
+		{
+		case Connection::STATUS_OK:
+			return true;
+
+		case Connection::STATUS_CLOSED:
+			return false;
+
+		case Connection::STATUS_BLOCKED:
+			blocked = true;
+			break;
+
+		case Connection::STATUS_DROPPED:
+			Drop( records );
+			return true;
+		}
+	}
+
+	// the console is falling behind, frames that can't be lost skip the policy
+	if( !essential )
+	{
+		if( client_policy.policy == POLICY_SAMPLE &&
+			++sample_counter % client_policy.sample_rate != 0 )
+		{
+			Drop( records );
+			return true;
+		}
+
+		if( !MakeRoom( size ) )
+		{
+			Drop( records );
+			return true;
+		}
+	}
+
+	if( !frame )
+		frame = std::make_shared<Frame>( data, size );
+
+	QueuedFrame queued;
+	queued.frame = frame;
+	queued.records = records;
+	queued.gap = pending_gap;
+	queued.essential = essential;
+	frames.push_back( queued );
+	pending_gap = 0;
+	queued_bytes += size;
+	return true;
+}
+
+bool Client::Flush( )
+{
+	while( !frames.empty( ) && !blocked )
+	{
+		QueuedFrame &queued = frames.front( );
+		switch( WriteFrame( queued.frame->GetData( ), queued.frame->GetSize( ), queued.gap ) )
+		{
+		case Connection::STATUS_OK:
+			queued_bytes -= queued.frame->GetSize( );
+			frames.pop_front( );
+			break;
+
+		case Connection::STATUS_CLOSED:
+			return false;
+
+		case Connection::STATUS_BLOCKED:
+			blocked = true;
+			break;
+
+		case Connection::STATUS_DROPPED:
+		{
+			// the next frame reports both its own gap and these records
+			const uint64_t lost = queued.gap + queued.records;
+			dropped += queued.records;
+			queued_bytes -= queued.frame->GetSize( );
+			frames.pop_front( );
+			if( frames.empty( ) )
+				pending_gap += lost;
+			else
+				frames.front( ).gap += lost;
+
+			break;
+		}
+		}
+	}
+
+	// report losses now instead of waiting for the next frame
+	if( frames.empty( ) && !blocked && pending_gap != 0 )
+		switch( WriteGap( pending_gap ) )
+		{
+		case Connection::STATUS_OK:
+			pending_gap = 0;
+			break;
+
+		case Connection::STATUS_CLOSED:
+			return false;
+
+		case Connection::STATUS_BLOCKED:
+			blocked = true;
+			break;
+
+		case Connection::STATUS_DROPPED:
+			// a gap frame always fits, keep it for the next frame anyway
+			break;
+		}
+
+	return true;
+}
+
+void Client::SetWritable( )
+{
+	blocked = false;
+}
+
+bool Client::IsOverBudget( size_t size ) const
+{
+	return ( !frames.empty( ) || blocked ) && queued_bytes + size > client_policy.budget;
+}
+
+const ClientPolicy &Client::GetPolicy( ) const
+{
+	return client_policy;
+}
+
+void Client::SetPolicy( const ClientPolicy &policy )
+{
+	client_policy = policy;
+	sample_counter = 0;
+}
+
+uint64_t Client::GetDropped( ) const
+{
+	return dropped;
+}
+
+size_t Client::GetQueuedFrames( ) const
+{
+	return frames.size( );
+}
+
+size_t Client::GetQueuedBytes( ) const
+{
+	return queued_bytes;
+}
+
+const ClientCounters &Client::GetCounters( ) const
+{
+	return counters;
+}
+
+uint32_t Client::GetKnownGroups( ) const
+{
+	return known_groups;
+}
+
+void Client::SetKnownGroups( uint32_t count )
+{
+	known_groups = count;
+}
+
+uint32_t Client::GetFeatures( ) const
+{
+	return enabled_features;
+}
+
+void Client::SetFeatures( uint32_t features )
+{
+	enabled_features = features;
+}
+
+Channel *Client::GetChannel( ) const
+{
+	return client_channel;
+}
+
+void Client::SetChannel( Channel *channel )
+{
+	client_channel = channel;
+}
+
+Connection::Status Client::Write( const void *data, size_t size )
+{
+	const MultiLibrary::IoVector vector = { data, size };
+	return Write( &vector, 1, size );
+}
+
+Connection::Status Client::Write( const MultiLibrary::IoVector *vectors, size_t count, size_t size )
+{
+	const uint64_t start = Clock::Ticks( );
+	const Connection::Status status = count == 1 ?
+		client_connection->Write( vectors[0].data, vectors[0].size ) :
+		client_connection->WriteV( vectors, count );
+	write_histogram.Add( Clock::Ticks( ) - start );
+
+	switch( status )
+	{
+	case Connection::STATUS_OK:
+		++counters.frames;
+		counters.bytes += size;
+		break;
+
+	case Connection::STATUS_CLOSED:
+		++counters.write_errors;
+		break;
+
+	case Connection::STATUS_BLOCKED:
+		++counters.blocked_writes;
+		break;
+
+	case Connection::STATUS_DROPPED:
+		// the records are counted as lost by the caller
+		break;
+	}
+
+	return status;
+}
+
+Connection::Status Client::WriteGap( uint64_t records )
+{
+	uint8_t data[gap_frame_size];
+	MultiLibrary::MemoryBuffer buffer( data, sizeof( data ) );
+	EncodeFrameHeader( buffer, 0, static_cast<uint32_t>( gap_frame_size - frame_header_size ) );
+	EncodeGapRecord( buffer, records );
+	return Write( data, sizeof( data ) );
+}
+
+Connection::Status Client::WriteFrame( const uint8_t *data, size_t size, uint64_t &gap )
+{
+	if( gap == 0 )
+		return Write( data, size );
+
+	FrameHeader header;
+	LoadFields( data, header );
+
+	Connection::Status status = Connection::STATUS_OK;
+	if( ( header.flags & FRAME_COMPRESSED ) != 0 )
+	{
+		// compressed records can't be prefixed, the gap needs its own frame
+		status = WriteGap( gap );
+		if( status == Connection::STATUS_OK )
+		{
+			gap = 0;
+			status = Write( data, size );
+		}
+
+		return status;
+	}
+
+	// the gap goes in front of the records of this frame, under a new frame
+	// header, and both are gathered into a single write
+	uint8_t prefix[gap_frame_size];
+	MultiLibrary::MemoryBuffer buffer( prefix, sizeof( prefix ) );
+	EncodeFrameHeader(
+		buffer,
+		header.flags,
+		static_cast<uint32_t>( gap_frame_size - frame_header_size + header.length )
+	);
+	EncodeGapRecord( buffer, gap );
+
+	const MultiLibrary::IoVector vectors[] = {
+		{ prefix, sizeof( prefix ) },
+		{ data + frame_header_size, size - frame_header_size }
+	};
+	status = Write( vectors, 2, sizeof( prefix ) + size - frame_header_size );
+	if( status == Connection::STATUS_OK )
+		gap = 0;
+
+	return status;
+}
+
+bool Client::MakeRoom( size_t size )
+{
+	if( queued_bytes + size <= client_policy.budget )
+		return true;
+
+	if( client_policy.policy != POLICY_DROP_OLDEST )
+		return false;
+
+	// what was lost is reported right before the next frame that survives
+	auto it = frames.begin( );
+	while( queued_bytes + size > client_policy.budget && it != frames.end( ) )
+	{
+		if( it->essential )
+		{
+			++it;
+			continue;
+		}
+
+		const uint64_t gap = it->gap + it->records;
+		dropped += it->records;
+		queued_bytes -= it->frame->GetSize( );
+		it = frames.erase( it );
+		if( it != frames.end( ) )
+			it->gap += gap;
+		else
+			pending_gap += gap;
+	}
+
+	return queued_bytes + size <= client_policy.budget;
+}
+
+void Client::Drop( uint32_t records )
+{
+	pending_gap += records;
+	dropped += records;
+}
+
+} // namespace xconsole
\ No newline at end of file
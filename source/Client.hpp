@@ -0,0 +1,226 @@
+#pragma once
+
+#include <Frame.hpp>
+#include <Protocol.hpp>
+#include <Stats.hpp>
+#include <Transport.hpp>
+#include <cstdint>
+#include <deque>
+
+namespace xconsole
+{
+
+class Channel;
+
+/*!
+ \brief How a client deals with a console that doesn't keep up.
+ */
+struct ClientPolicy
+{
+	ClientPolicy( );
+
+	BackpressurePolicy policy; ///< What to do when the budget is used up
+	size_t budget; ///< Bytes of frames that can be queued
+	int block_timeout; ///< Milliseconds to hold the server, with POLICY_BLOCK
+	uint32_t sample_rate; ///< Keep one in this many frames, with POLICY_SAMPLE
+};
+
+/*!
+ \brief What happened to the writes to a console.
+ */
+struct ClientCounters
+{
+	ClientCounters( );
+
+	uint64_t frames; ///< Frames written, gap frames included
+	uint64_t bytes; ///< Bytes written
+	uint64_t blocked_writes; ///< Writes that found the connection full
+	uint64_t write_errors; ///< Writes that failed
+};
+
+/*!
+ \brief A connected console, with its own queue of frames waiting to be sent.
+
+ A client that stops reading only grows its own queue, up to its budget,
+ and never delays other clients unless its policy says so. Records lost
+ along the way are reported to the console with gap records.
+ */
+class Client
+{
+public:
+	/*!
+	 \brief Create a client for the provided connection.
+
+	 \param connection Connection to the console.
+	 \param policy Initial backpressure policy.
+	 \param write_latency Histogram of how long writes take.
+	 */
+	Client( Connection *connection, const ClientPolicy &policy, Histogram &write_latency );
+
+	/*!
+	 \brief Return the connection to the console.
+
+	 \return Connection to the console.
+	 */
+	Connection *GetConnection( ) const;
+
+	/*!
+	 \brief Send a frame.
+
+	 The frame is written right away when nothing is queued. Otherwise it is
+	 queued, as a frame object created on first use and shared between
+	 clients, or dropped according to the policy.
+
+	 \param data Frame data.
+	 \param size Size of the frame.
+	 \param records Amount of records in the frame, reported if it is lost.
+	 \param frame Frame object holding this data, if already created.
+	 \param essential Whether the frame must never be dropped.
+
+	 \return false if the connection was closed, true otherwise.
+	 */
+	bool Send(
+		const uint8_t *data,
+		size_t size,
+		uint32_t records,
+		FramePtr &frame,
+		bool essential = false
+	);
+
+	/*!
+	 \brief Write as many queued frames as the connection accepts.
+
+	 \return false if the connection was closed, true otherwise.
+	 */
+	bool Flush( );
+
+	/*!
+	 \brief Mark the connection as writable again.
+	 */
+	void SetWritable( );
+
+	/*!
+	 \brief Tell if a frame of the provided size would go over the budget.
+
+	 \param size Size of the frame.
+
+	 \return true if the frame doesn't fit, false otherwise.
+	 */
+	bool IsOverBudget( size_t size ) const;
+
+	/*!
+	 \brief Return the backpressure policy.
+
+	 \return Backpressure policy.
+	 */
+	const ClientPolicy &GetPolicy( ) const;
+
+	/*!
+	 \brief Change the backpressure policy.
+
+	 \param policy New backpressure policy.
+	 */
+	void SetPolicy( const ClientPolicy &policy );
+
+	/*!
+	 \brief Return the amount of records lost by this console.
+
+	 \return Amount of lost records.
+	 */
+	uint64_t GetDropped( ) const;
+
+	/*!
+	 \brief Return the amount of frames waiting to be written.
+
+	 \return Amount of queued frames.
+	 */
+	size_t GetQueuedFrames( ) const;
+
+	/*!
+	 \brief Return the amount of bytes waiting to be written.
+
+	 \return Amount of queued bytes.
+	 */
+	size_t GetQueuedBytes( ) const;
+
+	/*!
+	 \brief Return what happened to the writes to the console.
+
+	 \return Write counters.
+	 */
+	const ClientCounters &GetCounters( ) const;
+
+	/*!
+	 \brief Return the amount of spew groups the console has been told about.
+
+	 \return Amount of known groups.
+	 */
+	uint32_t GetKnownGroups( ) const;
+
+	/*!
+	 \brief Set the amount of spew groups the console has been told about.
+
+	 \param count Amount of known groups.
+	 */
+	void SetKnownGroups( uint32_t count );
+
+	/*!
+	 \brief Return the optional protocol features enabled for the console.
+
+	 \return Enabled features, a combination of Feature values.
+	 */
+	uint32_t GetFeatures( ) const;
+
+	/*!
+	 \brief Set the optional protocol features enabled for the console.
+
+	 \param features Enabled features, a combination of Feature values.
+	 */
+	void SetFeatures( uint32_t features );
+
+	/*!
+	 \brief Return the channel the console receives frames from.
+
+	 \return Channel of the console.
+	 */
+	Channel *GetChannel( ) const;
+
+	/*!
+	 \brief Set the channel the console receives frames from.
+
+	 \param channel Channel of the console.
+	 */
+	void SetChannel( Channel *channel );
+
+private:
+	struct QueuedFrame
+	{
+		FramePtr frame;
+		uint32_t records;
+		uint64_t gap; ///< Records lost right before this frame
+		bool essential;
+	};
+
+	Connection::Status Write( const void *data, size_t size );
+	Connection::Status Write( const MultiLibrary::IoVector *vectors, size_t count, size_t size );
+	Connection::Status WriteGap( uint64_t records );
+	Connection::Status WriteFrame( const uint8_t *data, size_t size, uint64_t &gap );
+	bool MakeRoom( size_t size );
+	void Drop( uint32_t records );
+
+	Connection *client_connection;
+	ClientPolicy client_policy;
+	std::deque<QueuedFrame> frames;
+	size_t queued_bytes;
+	bool blocked;
+	uint64_t pending_gap;
+	uint64_t dropped;
+	ClientCounters counters;
+	Histogram &write_histogram;
+	uint32_t sample_counter;
+	uint32_t known_groups;
+	uint32_t enabled_features;
+	Channel *client_channel;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <Clock.hpp>
+
+#if defined _MSC_VER && ( defined _M_IX86 || defined _M_X64 )
+#include <intrin.h>
+#define XCONSOLE_HAS_TSC
+#elif defined __i386__ || defined __x86_64__
+#include <cpuid.h>
+#include <x86intrin.h>
+#define XCONSOLE_HAS_TSC
+#endif
+
+#if defined __linux__
+#include <time.h>
+#endif
+
+namespace xconsole
+{
+
+// shorter calibrations are dominated by the time it takes to read the clocks
+static const int64_t min_calibration_time = 100000;
+
+static int64_t SteadyNanoseconds( )
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now( ).time_since_epoch( )
+	).count( );
+}
+
+static bool HasInvariantTsc( )
+{
+#if defined XCONSOLE_HAS_TSC && defined _MSC_VER
+	int registers[4];
+	__cpuid( registers, 0x80000000 );
+	if( static_cast<unsigned int>( registers[0] ) < 0x80000007 )
+		return false;
+
+	__cpuid( registers, 0x80000007 );
+	return ( registers[3] & ( 1 << 8 ) ) != 0;
+#elif defined XCONSOLE_HAS_TSC
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	return __get_cpuid( 0x80000007, &eax, &ebx, &ecx, &edx ) != 0 && ( edx & ( 1 << 8 ) ) != 0;
+#else
+	return false;
+#endif
+}
+
+static const bool use_tsc = HasInvariantTsc( );
+
+Clock::Clock( ) :
+	base_ticks( 0 ),
+	base_nanoseconds( 0 ),
+	nanoseconds_per_tick( 1.0 )
+{ }
+
+uint64_t Clock::Ticks( )
+{
+#if defined XCONSOLE_HAS_TSC
+	if( use_tsc )
+		return __rdtsc( );
+#endif
+
+#if defined __linux__
+	// served by the vDSO from the last timer tick, so it never enters the kernel
+	timespec now;
+	clock_gettime( CLOCK_MONOTONIC_COARSE, &now );
+	return static_cast<uint64_t>( now.tv_sec ) * 1000000000 + static_cast<uint64_t>( now.tv_nsec );
+#else
+	return static_cast<uint64_t>( SteadyNanoseconds( ) );
+#endif
+}
+
+void Clock::Reset( )
+{
+	base_ticks = Ticks( );
+	nanoseconds_per_tick = 1.0;
+	if( !use_tsc )
+	{
+		// ticks already are nanoseconds on the same clock
+		base_nanoseconds = static_cast<int64_t>( base_ticks );
+		return;
+	}
+
+	// a first estimate of the rate, which Calibrate refines from then on
+	base_nanoseconds = SteadyNanoseconds( );
+	while( SteadyNanoseconds( ) - base_nanoseconds < min_calibration_time )
+		continue;
+
+	Calibrate( );
+}
+
+void Clock::Calibrate( )
+{
+	if( !use_tsc )
+		return;
+
+	const uint64_t ticks = Ticks( );
+	const int64_t elapsed = SteadyNanoseconds( ) - base_nanoseconds;
+	if( elapsed >= min_calibration_time && ticks > base_ticks )
+		nanoseconds_per_tick = static_cast<double>( elapsed ) / static_cast<double>( ticks - base_ticks );
+}
+
+uint64_t Clock::ToNanoseconds( uint64_t ticks ) const
+{
+	const double offset = static_cast<double>( static_cast<int64_t>( ticks - base_ticks ) );
+	return static_cast<uint64_t>( base_nanoseconds + static_cast<int64_t>( offset * nanoseconds_per_tick ) );
+}
+
+uint64_t Clock::ToDuration( uint64_t ticks ) const
+{
+	return static_cast<uint64_t>( static_cast<double>( ticks ) * nanoseconds_per_tick );
+}
+
+} // namespace xconsole
\ No newline at end of file
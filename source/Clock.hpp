@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace xconsole
+{
+
+/*!
+ \brief Timestamps cheap enough to take for every record.
+
+ Ticks come from the TSC when it runs at a constant rate, or from a coarse
+ monotonic clock otherwise. Converting them to nanoseconds is left to the
+ writer thread, which keeps calibrating the TSC rate against the steady
+ clock as time goes by.
+ */
+class Clock
+{
+public:
+	Clock( );
+
+	/*!
+	 \brief Read the current ticks.
+
+	 Safe to call from any thread.
+
+	 \return Current ticks.
+	 */
+	static uint64_t Ticks( );
+
+	/*!
+	 \brief Take the reference point conversions are relative to, which
+	 must be done before converting ticks.
+
+	 Spins for a fraction of a millisecond to get a first estimate of the
+	 TSC rate.
+	 */
+	void Reset( );
+
+	/*!
+	 \brief Refine the tick rate with the time elapsed since Reset.
+	 */
+	void Calibrate( );
+
+	/*!
+	 \brief Convert ticks to nanoseconds.
+
+	 \param ticks Ticks returned by Ticks.
+
+	 \return Nanoseconds on the steady clock, which is CLOCK_MONOTONIC on
+	 Linux and the performance counter on Windows.
+	 */
+	uint64_t ToNanoseconds( uint64_t ticks ) const;
+
+	/*!
+	 \brief Convert an amount of ticks to a duration.
+
+	 \param ticks Difference between two values returned by Ticks.
+
+	 \return Duration in nanoseconds.
+	 */
+	uint64_t ToDuration( uint64_t ticks ) const;
+
+private:
+	uint64_t base_ticks;
+	int64_t base_nanoseconds;
+	double nanoseconds_per_tick;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include <Filter.hpp>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace xconsole
+{
+
+// expressions run on the writer thread with a backtracking matcher, which
+// is only kept in check by keeping both patterns and messages short
+static const size_t max_pattern_length = 256;
+static const size_t max_match_length = 512;
+static const size_t max_quantifiers = 4;
+static const unsigned long max_repeat = 16;
+
+/*
+ Reads a "{n}", "{n,}" or "{n,m}" quantifier starting at the brace and moves
+ past it, telling whether it's unbounded. Returns false if it's malformed or
+ repeats too much.
+ */
+static bool ReadRepeat( const std::string &pattern, size_t &k, bool &unbounded )
+{
+	const size_t end = pattern.find( '}', k );
+	if( end == std::string::npos )
+		return false;
+
+	const std::string range = pattern.substr( k + 1, end - k - 1 );
+	const size_t comma = range.find( ',' );
+	const std::string minimum = range.substr( 0, comma );
+	const std::string maximum = comma != std::string::npos ? range.substr( comma + 1 ) : minimum;
+	if( minimum.empty( ) || minimum.size( ) > 2 || maximum.size( ) > 2 ||
+		minimum.find_first_not_of( "0123456789" ) != std::string::npos ||
+		maximum.find_first_not_of( "0123456789" ) != std::string::npos )
+		return false;
+
+	unbounded = maximum.empty( );
+	k = end;
+	return std::stoul( minimum ) <= max_repeat &&
+		( unbounded || std::stoul( maximum ) <= max_repeat );
+}
+
+/*
+ Only lets through patterns a backtracking matcher gets through quickly on
+ messages up to max_match_length: a single unbounded quantifier, a few
+ small bounded ones, no repeated group holding a quantifier or alternatives
+ (like "(a*)*" or "(.|\n)*") and no backreferences. This is a limit on the
+ work, not a proof, which is why the matcher is guarded as well.
+ */
+static bool IsSafePattern( const std::string &pattern )
+{
+	if( pattern.size( ) > max_pattern_length )
+		return false;
+
+	struct Group
+	{
+		bool quantified;
+		bool alternatives;
+	};
+
+	size_t quantifiers = 0;
+	bool has_unbounded = false;
+	std::vector<Group> groups( 1, Group( ) );
+	bool closed_risky = false;
+	for( size_t k = 0; k < pattern.size( ); ++k )
+	{
+		const char c = pattern[k];
+		const bool follows_group = closed_risky;
+		closed_risky = false;
+		switch( c )
+		{
+		case '\\':
+			if( ++k < pattern.size( ) && pattern[k] >= '1' && pattern[k] <= '9' )
+				return false;
+
+			break;
+
+		case '[':
+			// classes are a single atom, skip to their end
+			for( ++k; k < pattern.size( ) && pattern[k] != ']'; ++k )
+				if( pattern[k] == '\\' )
+					++k;
+
+			break;
+
+		case '(':
+			// the '?' of "(?:", "(?=" and "(?!" isn't a quantifier
+			if( k + 2 < pattern.size( ) && pattern[k + 1] == '?' )
+				k += 2;
+
+			groups.push_back( Group( ) );
+			break;
+
+		case ')':
+		{
+			if( groups.size( ) == 1 )
+				return false;
+
+			const Group group = groups.back( );
+			groups.pop_back( );
+			groups.back( ).quantified |= group.quantified;
+			closed_risky = group.quantified || group.alternatives;
+			break;
+		}
+
+		case '|':
+			groups.back( ).alternatives = true;
+			break;
+
+		case '*':
+		case '+':
+		case '?':
+		case '{':
+		{
+			if( follows_group || ++quantifiers > max_quantifiers )
+				return false;
+
+			bool unbounded = c == '*' || c == '+';
+			if( c == '{' && !ReadRepeat( pattern, k, unbounded ) )
+				return false;
+
+			if( unbounded && has_unbounded )
+				return false;
+
+			has_unbounded |= unbounded;
+
+			// a '?' after a quantifier only makes it lazy
+			if( k + 1 < pattern.size( ) && pattern[k + 1] == '?' )
+				++k;
+
+			groups.back( ).quantified = true;
+			break;
+		}
+		}
+	}
+
+	return true;
+}
+
+Filter::Filter( const SubscribeRecord &subscription, const GroupTable &groups, uint64_t &match_errors ) :
+	subscription( subscription ),
+	group_table( groups ),
+	match_errors( match_errors ),
+	valid( subscription.pattern_kind < PATTERN_COUNT )
+{
+	if( subscription.pattern_kind != PATTERN_REGEX )
+		return;
+
+	if( !IsSafePattern( subscription.pattern ) )
+	{
+		valid = false;
+		return;
+	}
+
+	try
+	{
+		expression.assign(
+			subscription.pattern,
+			std::regex_constants::ECMAScript | std::regex_constants::optimize
+		);
+	}
+	catch( const std::regex_error & )
+	{
+		valid = false;
+	}
+}
+
+bool Filter::IsValid( ) const
+{
+	return valid;
+}
+
+const SubscribeRecord &Filter::GetSubscription( ) const
+{
+	return subscription;
+}
+
+bool Filter::WantsGroup( uint32_t group )
+{
+	// groups that didn't fit the table have no name
+	if( group >= GroupTable::max_groups )
+		return IsAllowed( nullptr );
+
+	if( group >= verdicts.size( ) )
+		verdicts.resize( group + 1, VERDICT_UNKNOWN );
+
+	if( verdicts[group] == VERDICT_UNKNOWN )
+		verdicts[group] = IsAllowed( group_table.Find( group ) ) ? VERDICT_ALLOW : VERDICT_DENY;
+
+	return verdicts[group] == VERDICT_ALLOW;
+}
+
+bool Filter::Matches( int32_t type, int32_t level, uint32_t group, const char *message, size_t length )
+{
+	if( type < 0 || type >= 32 || ( subscription.type_mask & ( 1u << type ) ) == 0 )
+		return false;
+
+	if( level < subscription.min_level || !WantsGroup( group ) )
+		return false;
+
+	switch( subscription.pattern_kind )
+	{
+	case PATTERN_SUBSTRING:
+	{
+		const std::string &pattern = subscription.pattern;
+		return std::search(
+			message,
+			message + length,
+			pattern.begin( ),
+			pattern.end( )
+		) != message + length || pattern.empty( );
+	}
+
+	case PATTERN_REGEX:
+		// some engines throw on complex inputs instead of crashing, which
+		// must not leave the writer thread
+		try
+		{
+			return std::regex_search(
+				message,
+				message + std::min( length, max_match_length ),
+				expression
+			);
+		}
+		catch( const std::regex_error & )
+		{
+			++match_errors;
+			return false;
+		}
+
+	default:
+		return true;
+	}
+}
+
+bool Filter::IsAllowed( const std::string *name ) const
+{
+	const std::vector<std::string> &allow = subscription.allow_groups;
+	const std::vector<std::string> &deny = subscription.deny_groups;
+	if( name == nullptr )
+		return allow.empty( );
+
+	return ( allow.empty( ) || std::find( allow.begin( ), allow.end( ), *name ) != allow.end( ) ) &&
+		std::find( deny.begin( ), deny.end( ), *name ) == deny.end( );
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <Protocol.hpp>
+#include <GroupTable.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <regex>
+#include <vector>
+
+namespace xconsole
+{
+
+/*!
+ \brief Predicate compiled from a console subscription.
+
+ Cheap checks come first: the type mask and level are plain comparisons and
+ group verdicts are resolved once per group identifier, so only records that
+ pass them pay for the pattern. Not thread-safe, it's used by the writer.
+ */
+class Filter
+{
+public:
+	/*!
+	 \brief Compile a subscription.
+
+	 \param subscription Subscription to compile.
+	 \param groups Table the group identifiers of records come from.
+	 \param match_errors Counter of matches the regular expression engine gave up on.
+	 */
+	Filter( const SubscribeRecord &subscription, const GroupTable &groups, uint64_t &match_errors );
+
+	/*!
+	 \brief Tell if the subscription could be compiled.
+
+	 \return false if the pattern kind is unknown or the regular expression
+	 is malformed, too long or could backtrack without end, true otherwise.
+	 */
+	bool IsValid( ) const;
+
+	/*!
+	 \brief Return the subscription this filter was compiled from.
+
+	 \return Subscription.
+	 */
+	const SubscribeRecord &GetSubscription( ) const;
+
+	/*!
+	 \brief Tell if a group is let through.
+
+	 \param group Group identifier.
+
+	 \return true if records of the group can match, false otherwise.
+	 */
+	bool WantsGroup( uint32_t group );
+
+	/*!
+	 \brief Tell if a record is let through.
+
+	 \param type Spew type.
+	 \param level Spew level.
+	 \param group Spew group identifier.
+	 \param message Message text.
+	 \param length Length of the message.
+
+	 \return true if the record matches, false otherwise (including when the
+	 regular expression engine gives up, which is counted).
+	 */
+	bool Matches( int32_t type, int32_t level, uint32_t group, const char *message, size_t length );
+
+private:
+	enum GroupVerdict
+	{
+		VERDICT_UNKNOWN,
+		VERDICT_ALLOW,
+		VERDICT_DENY
+	};
+
+	bool IsAllowed( const std::string *name ) const;
+
+	SubscribeRecord subscription;
+	const GroupTable &group_table;
+	uint64_t &match_errors;
+	std::vector<uint8_t> verdicts;
+	std::regex expression;
+	bool valid;
+};
+
+} // namespace xconsole
\ No newline at end of file
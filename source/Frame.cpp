@@ -0,0 +1,20 @@
+#include <Frame.hpp>
+
+namespace xconsole
+{
+
+Frame::Frame( const uint8_t *data, size_t size ) :
+	buffer( data, size )
+{ }
+
+const uint8_t *Frame::GetData( ) const
+{
+	return buffer.GetBuffer( );
+}
+
+size_t Frame::GetSize( ) const
+{
+	return static_cast<size_t>( buffer.Size( ) );
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ByteBuffer.hpp>
+#include <memory>
+
+namespace xconsole
+{
+
+/*!
+ \brief Encoded data that is sent to consoles.
+
+ Frames are immutable once created and shared between every client that
+ still has to send them.
+ */
+class Frame
+{
+public:
+	/*!
+	 \brief Create a frame from the provided data.
+
+	 \param data Data to copy.
+	 \param size Size of the data.
+	 */
+	Frame( const uint8_t *data, size_t size );
+
+	/*!
+	 \brief Return pointer to the frame data.
+
+	 \return Pointer to the frame data.
+	 */
+	const uint8_t *GetData( ) const;
+
+	/*!
+	 \brief Return the size of the frame data.
+
+	 \return Size of the frame data.
+	 */
+	size_t GetSize( ) const;
+
+private:
+	MultiLibrary::ByteBuffer buffer;
+};
+
+typedef std::shared_ptr<const Frame> FramePtr;
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,100 @@
+#include <GroupTable.hpp>
+#include <cstring>
+
+namespace xconsole
+{
+
+static uint32_t HashName( const char *name, size_t length )
+{
+	// FNV-1a, group names are short and this only runs once per spew
+	uint32_t hash = 2166136261u;
+	for( size_t k = 0; k < length; ++k )
+	{
+		hash ^= static_cast<uint8_t>( name[k] );
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+GroupTable::GroupTable( ) :
+	entry_count( 0 )
+{
+	for( std::atomic<Entry *> &slot : slots )
+		slot.store( nullptr, std::memory_order_relaxed );
+
+	for( std::atomic<Entry *> &entry : entries )
+		entry.store( nullptr, std::memory_order_relaxed );
+}
+
+GroupTable::~GroupTable( )
+{
+	for( std::atomic<Entry *> &entry : entries )
+		delete entry.load( std::memory_order_relaxed );
+}
+
+uint32_t GroupTable::Intern( const char *name, size_t length )
+{
+	const uint32_t hash = HashName( name, length );
+
+	// entries are immutable once published, so probing needs no lock
+	uint32_t index = hash & ( slot_count - 1 );
+	while( true )
+	{
+		Entry *entry = slots[index].load( std::memory_order_acquire );
+		if( entry == nullptr )
+			break;
+
+		if( entry->hash == hash && entry->name.size( ) == length &&
+			std::memcmp( entry->name.data( ), name, length ) == 0 )
+			return entry->group;
+
+		index = ( index + 1 ) & ( slot_count - 1 );
+	}
+
+	std::lock_guard<std::mutex> lock( insert_mutex );
+
+	// another thread might have added it, or something colliding, meanwhile
+	while( true )
+	{
+		Entry *entry = slots[index].load( std::memory_order_relaxed );
+		if( entry == nullptr )
+			break;
+
+		if( entry->hash == hash && entry->name.size( ) == length &&
+			std::memcmp( entry->name.data( ), name, length ) == 0 )
+			return entry->group;
+
+		index = ( index + 1 ) & ( slot_count - 1 );
+	}
+
+	const uint32_t group = entry_count.load( std::memory_order_relaxed );
+	if( group == max_groups )
+		return invalid_group;
+
+	Entry *entry = new Entry;
+	entry->hash = hash;
+	entry->group = group;
+	entry->name.assign( name, length );
+
+	entries[group].store( entry, std::memory_order_release );
+	entry_count.store( group + 1, std::memory_order_release );
+	slots[index].store( entry, std::memory_order_release );
+	return group;
+}
+
+const std::string *GroupTable::Find( uint32_t group ) const
+{
+	if( group >= max_groups )
+		return nullptr;
+
+	const Entry *entry = entries[group].load( std::memory_order_acquire );
+	return entry != nullptr ? &entry->name : nullptr;
+}
+
+uint32_t GroupTable::Size( ) const
+{
+	return entry_count.load( std::memory_order_acquire );
+}
+
+} // namespace xconsole
\ No newline at end of file
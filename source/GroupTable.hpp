@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+namespace xconsole
+{
+
+/*!
+ \brief Assigns small identifiers to spew group names.
+
+ Identifiers are handed out in order, starting at 0, and never change or get
+ reused, so consoles only need to learn each group once. Looking up a known
+ group is lock-free and allocation-free, only new groups take a lock.
+ */
+class GroupTable
+{
+public:
+	/*!
+	 \brief Identifier returned when the table is full.
+	 */
+	static const uint32_t invalid_group = 0xFFFFFFFF;
+
+	/*!
+	 \brief Maximum amount of groups the table can hold.
+	 */
+	static const uint32_t max_groups = 4096;
+
+	GroupTable( );
+	~GroupTable( );
+
+	/*!
+	 \brief Return the identifier of a group, adding it if needed.
+
+	 Safe to call from any thread.
+
+	 \param name Group name.
+	 \param length Length of the group name, without terminator.
+
+	 \return Group identifier or invalid_group if the table is full.
+	 */
+	uint32_t Intern( const char *name, size_t length );
+
+	/*!
+	 \brief Return the name of a group.
+
+	 Safe to call from any thread.
+
+	 \param group Group identifier.
+
+	 \return Group name or nullptr if the identifier isn't assigned.
+	 */
+	const std::string *Find( uint32_t group ) const;
+
+	/*!
+	 \brief Return the amount of identifiers assigned so far.
+
+	 \return Amount of groups.
+	 */
+	uint32_t Size( ) const;
+
+private:
+	struct Entry
+	{
+		uint32_t hash;
+		uint32_t group;
+		std::string name;
+	};
+
+	static const uint32_t slot_count = max_groups * 2;
+
+	std::atomic<Entry *> slots[slot_count];
+	std::atomic<Entry *> entries[max_groups];
+	std::atomic<uint32_t> entry_count;
+	std::mutex insert_mutex;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include <History.hpp>
+
+namespace xconsole
+{
+
+History::History( ) :
+	history_bytes( 0 ),
+	history_limit( 0 )
+{ }
+
+void History::SetLimit( size_t limit )
+{
+	history_limit = limit;
+	while( history_bytes > history_limit )
+	{
+		history_bytes -= frames.front( )->GetSize( );
+		frames.pop_front( );
+	}
+}
+
+bool History::IsEnabled( ) const
+{
+	return history_limit != 0;
+}
+
+void History::Add( const FramePtr &frame )
+{
+	if( frame->GetSize( ) > history_limit )
+		return;
+
+	frames.push_back( frame );
+	history_bytes += frame->GetSize( );
+	while( history_bytes > history_limit )
+	{
+		history_bytes -= frames.front( )->GetSize( );
+		frames.pop_front( );
+	}
+}
+
+const std::deque<FramePtr> &History::GetFrames( ) const
+{
+	return frames;
+}
+
+void History::Clear( )
+{
+	frames.clear( );
+	history_bytes = 0;
+}
+
+} // namespace xconsole
\ No newline at end of file
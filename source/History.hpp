@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Frame.hpp>
+#include <cstddef>
+#include <deque>
+
+namespace xconsole
+{
+
+/*!
+ \brief The most recent frames, kept for consoles that connect later.
+
+ Holds references to the same frames clients send, so keeping them costs
+ no extra copies. The oldest frames are let go once the limit is reached.
+ */
+class History
+{
+public:
+	History( );
+
+	/*!
+	 \brief Set the maximum amount of frame bytes to keep.
+
+	 \param limit Maximum size, 0 to keep nothing.
+	 */
+	void SetLimit( size_t limit );
+
+	/*!
+	 \brief Tell if frames are being kept at all.
+
+	 \return true if the limit isn't 0, false otherwise.
+	 */
+	bool IsEnabled( ) const;
+
+	/*!
+	 \brief Add the newest frame, letting go of the oldest ones if needed.
+
+	 \param frame Frame to keep.
+	 */
+	void Add( const FramePtr &frame );
+
+	/*!
+	 \brief Return the frames kept, oldest first.
+
+	 \return Kept frames.
+	 */
+	const std::deque<FramePtr> &GetFrames( ) const;
+
+	/*!
+	 \brief Let go of every frame.
+	 */
+	void Clear( );
+
+private:
+	std::deque<FramePtr> frames;
+	size_t history_bytes;
+	size_t history_limit;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -36,10 +36,102 @@
 
 #include <InputStream.hpp>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
 
 namespace MultiLibrary
 {
 
+// non contiguous streams are read this many bytes at a time
+static const size_t string_chunk_size = 256;
+
+static size_t FindTerminator( const char *data, size_t length )
+{
+	const void *terminator = std::memchr( data, '\0', length );
+	return terminator != nullptr ?
+		static_cast<size_t>( static_cast<const char *>( terminator ) - data ) : length;
+}
+
+static size_t FindTerminator( const wchar_t *data, size_t length )
+{
+	const wchar_t *terminator = std::wmemchr( data, L'\0', length );
+	return terminator != nullptr ? static_cast<size_t>( terminator - data ) : length;
+}
+
+/*
+ Reads a NUL terminated string, passing it to output in as few pieces as
+ possible and consuming the terminator. Returns whether it was found, like
+ reading a character at a time would have.
+ */
+template<typename Char, typename Output>
+static bool ReadString( InputStream &stream, Output &output )
+{
+	size_t size = 0;
+	const uint8_t *data = stream.Peek( size );
+	if( data != nullptr && size >= sizeof( Char ) &&
+		reinterpret_cast<uintptr_t>( data ) % alignof( Char ) == 0 )
+	{
+		const size_t available = size / sizeof( Char );
+		const size_t length = FindTerminator( reinterpret_cast<const Char *>( data ), available );
+		output( reinterpret_cast<const Char *>( data ), length );
+		if( length < available )
+		{
+			stream.Seek( static_cast<int64_t>( ( length + 1 ) * sizeof( Char ) ), SEEKMODE_CUR );
+			return true;
+		}
+
+		// ran out without a terminator, continue like any other stream to hit the end
+		stream.Seek( static_cast<int64_t>( length * sizeof( Char ) ), SEEKMODE_CUR );
+	}
+
+	Char chunk[string_chunk_size / sizeof( Char )];
+	size_t received = 0;
+	while( ( received = stream.Read( chunk, sizeof( chunk ) ) / sizeof( Char ) ) != 0 )
+	{
+		const size_t length = FindTerminator( chunk, received );
+		output( chunk, length );
+		if( length < received )
+		{
+			// give back what was read past the terminator
+			stream.Seek( -static_cast<int64_t>( ( received - length - 1 ) * sizeof( Char ) ), SEEKMODE_CUR );
+			return true;
+		}
+	}
+
+	return false;
+}
+
+template<typename Char>
+struct ArrayOutput
+{
+	void operator( )( const Char *data, size_t length )
+	{
+		std::memcpy( array + offset, data, length * sizeof( Char ) );
+		offset += length;
+	}
+
+	Char *array;
+	size_t offset;
+};
+
+template<typename String>
+struct StringOutput
+{
+	void operator( )( const typename String::value_type *data, size_t length )
+	{
+		string.append( data, length );
+	}
+
+	String &string;
+};
+
+const uint8_t *InputStream::Peek( size_t &size ) const
+{
+	size = 0;
+	return nullptr;
+}
+
 InputStream &InputStream::operator>>( bool &data )
 {
 	bool value;
@@ -152,27 +244,17 @@ InputStream &InputStream::operator>>( char *data )
 {
 	assert( data != nullptr );
 
-	char ch = '\0';
-	size_t offset = 0;
-	while( Read( &ch, sizeof( ch ) ) == sizeof( ch ) )
-	{
-		data[offset] = ch;
-
-		if( ch == '\0' )
-			break;
-
-		++offset;
-	}
+	ArrayOutput<char> output = { data, 0 };
+	if( ReadString<char>( *this, output ) )
+		data[output.offset] = '\0';
 
 	return *this;
 }
 
 InputStream &InputStream::operator>>( std::string &data )
 {
-	char ch = '\0';
-	while( Read( &ch, sizeof( ch ) ) == sizeof( ch ) && ch != '\0' )
-		data += ch;
-
+	StringOutput<std::string> output = { data };
+	ReadString<char>( *this, output );
 	return *this;
 }
 
@@ -189,27 +271,17 @@ InputStream &InputStream::operator>>( wchar_t *data )
 {
 	assert( data != nullptr );
 
-	wchar_t ch = L'\0';
-	size_t offset = 0;
-	while( Read( &ch, sizeof( ch ) ) == sizeof( ch ) )
-	{
-		data[offset] = ch;
-
-		if( ch == L'\0' )
-			break;
-
-		++offset;
-	}
+	ArrayOutput<wchar_t> output = { data, 0 };
+	if( ReadString<wchar_t>( *this, output ) )
+		data[output.offset] = L'\0';
 
 	return *this;
 }
 
 InputStream &InputStream::operator>>( std::wstring &data )
 {
-	wchar_t ch = L'\0';
-	while( Read( &ch, sizeof( ch ) ) == sizeof( ch ) && ch != L'\0' )
-		data += ch;
-
+	StringOutput<std::wstring> output = { data };
+	ReadString<wchar_t>( *this, output );
 	return *this;
 }
 
@@ -58,6 +58,20 @@ public:
 	 */
 	virtual size_t Read( void *data, size_t size ) = 0;
 
+	/*!
+	 \brief Return the unread data, for streams backed by contiguous memory.
+
+	 Lets readers scan the data in place instead of reading it piece by
+	 piece. Moving past what was used is done with Seek. Streams made of
+	 several blocks of memory only return the rest of the current block.
+
+	 \param size Where to store the amount of bytes returned.
+
+	 \return Pointer to the unread data, or nullptr if the stream isn't
+	 backed by contiguous memory (the default).
+	 */
+	virtual const uint8_t *Peek( size_t &size ) const;
+
 	/*!
 	 \brief Read data from the buffer into a variable.
 
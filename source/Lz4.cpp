@@ -0,0 +1,242 @@
+#include <Lz4.hpp>
+#include <cstring>
+
+namespace xconsole
+{
+
+static const size_t min_match = 4;
+static const size_t last_literals = 5;
+static const size_t match_safety = 12;
+static const size_t max_offset = 65535;
+static const size_t skip_trigger = 6;
+
+static inline uint32_t Read32( const uint8_t *data )
+{
+	uint32_t value;
+	std::memcpy( &value, data, sizeof( value ) );
+	return value;
+}
+
+static inline uint32_t Hash32( uint32_t value, int bits )
+{
+	return ( value * 2654435761u ) >> ( 32 - bits );
+}
+
+static inline size_t MatchLength( const uint8_t *first, const uint8_t *second, const uint8_t *limit )
+{
+	const uint8_t *start = second;
+	while( second + sizeof( uint64_t ) <= limit )
+	{
+		uint64_t a, b;
+		std::memcpy( &a, first, sizeof( a ) );
+		std::memcpy( &b, second, sizeof( b ) );
+		const uint64_t difference = a ^ b;
+		if( difference != 0 )
+		{
+			// the lowest differing byte ends the match, data is little endian
+			size_t bytes = 0;
+			for( uint64_t mask = 0xFF; ( difference & mask ) == 0; mask <<= 8 )
+				++bytes;
+
+			return static_cast<size_t>( second - start ) + bytes;
+		}
+
+		first += sizeof( uint64_t );
+		second += sizeof( uint64_t );
+	}
+
+	while( second < limit && *first == *second )
+	{
+		++first;
+		++second;
+	}
+
+	return static_cast<size_t>( second - start );
+}
+
+static inline uint8_t *WriteLength( uint8_t *output, size_t length )
+{
+	for( ; length >= 255; length -= 255 )
+		*output++ = 255;
+
+	*output++ = static_cast<uint8_t>( length );
+	return output;
+}
+
+size_t Lz4CompressBound( size_t size )
+{
+	return size + size / 255 + 16;
+}
+
+size_t Lz4Encoder::Compress( const uint8_t *source, size_t size, uint8_t *destination, size_t capacity )
+{
+	const uint8_t *anchor = source;
+	const uint8_t *const end = source + size;
+	uint8_t *output = destination;
+	uint8_t *const output_end = destination + capacity;
+
+	if( size > match_safety )
+	{
+		std::memset( table, 0, sizeof( table ) );
+
+		// matches can't start in the last 12 bytes nor reach the last 5
+		const uint8_t *const match_start_limit = end - match_safety;
+		const uint8_t *const match_end_limit = end - last_literals;
+		const uint8_t *input = source + 1;
+		size_t attempts = 1 << skip_trigger;
+		while( input < match_start_limit )
+		{
+			const uint32_t sequence = Read32( input );
+			const uint32_t hash = Hash32( sequence, hash_bits );
+			const uint8_t *match = source + table[hash];
+			table[hash] = static_cast<uint32_t>( input - source );
+			if( match >= input || static_cast<size_t>( input - match ) > max_offset ||
+				Read32( match ) != sequence )
+			{
+				// step faster through data that doesn't compress
+				input += attempts++ >> skip_trigger;
+				continue;
+			}
+
+			attempts = 1 << skip_trigger;
+			while( input > anchor && match > source && input[-1] == match[-1] )
+			{
+				--input;
+				--match;
+			}
+
+			const size_t literals = static_cast<size_t>( input - anchor );
+			const size_t length = min_match +
+				MatchLength( match + min_match, input + min_match, match_end_limit );
+			if( output + 1 + literals + literals / 255 + 2 + 1 + length / 255 + 1 > output_end )
+				return 0;
+
+			uint8_t *token = output++;
+			*token = static_cast<uint8_t>( ( literals < 15 ? literals : 15 ) << 4 );
+			if( literals >= 15 )
+				output = WriteLength( output, literals - 15 );
+
+			std::memcpy( output, anchor, literals );
+			output += literals;
+
+			const size_t offset = static_cast<size_t>( input - match );
+			*output++ = static_cast<uint8_t>( offset );
+			*output++ = static_cast<uint8_t>( offset >> 8 );
+
+			const size_t extra = length - min_match;
+			*token |= static_cast<uint8_t>( extra < 15 ? extra : 15 );
+			if( extra >= 15 )
+				output = WriteLength( output, extra - 15 );
+
+			input += length;
+			anchor = input;
+
+			// remember a position inside the match, repeated lines benefit
+			if( input < match_start_limit )
+				table[Hash32( Read32( input - 2 ), hash_bits )] =
+					static_cast<uint32_t>( input - 2 - source );
+		}
+	}
+
+	const size_t literals = static_cast<size_t>( end - anchor );
+	if( output + 1 + literals + literals / 255 + 1 > output_end )
+		return 0;
+
+	uint8_t *token = output++;
+	*token = static_cast<uint8_t>( ( literals < 15 ? literals : 15 ) << 4 );
+	if( literals >= 15 )
+		output = WriteLength( output, literals - 15 );
+
+	if( literals != 0 )
+	{
+		std::memcpy( output, anchor, literals );
+		output += literals;
+	}
+
+	return static_cast<size_t>( output - destination );
+}
+
+size_t Lz4Decompress( const uint8_t *source, size_t size, uint8_t *destination, size_t capacity )
+{
+	const uint8_t *input = source;
+	const uint8_t *const input_end = source + size;
+	uint8_t *output = destination;
+	uint8_t *const output_end = destination + capacity;
+
+	while( input < input_end )
+	{
+		const uint8_t token = *input++;
+
+		size_t literals = token >> 4;
+		if( literals == 15 )
+		{
+			uint8_t byte;
+			do
+			{
+				if( input == input_end )
+					return 0;
+
+				byte = *input++;
+				literals += byte;
+			}
+			while( byte == 255 );
+		}
+
+		if( literals > static_cast<size_t>( input_end - input ) ||
+			literals > static_cast<size_t>( output_end - output ) )
+			return 0;
+
+		std::memcpy( output, input, literals );
+		input += literals;
+		output += literals;
+
+		// the last sequence only has literals
+		if( input == input_end )
+			break;
+
+		if( input_end - input < 2 )
+			return 0;
+
+		const size_t offset = input[0] | ( static_cast<size_t>( input[1] ) << 8 );
+		input += 2;
+		if( offset == 0 || offset > static_cast<size_t>( output - destination ) )
+			return 0;
+
+		size_t length = ( token & 15 ) + min_match;
+		if( ( token & 15 ) == 15 )
+		{
+			uint8_t byte;
+			do
+			{
+				if( input == input_end )
+					return 0;
+
+				byte = *input++;
+				length += byte;
+			}
+			while( byte == 255 );
+		}
+
+		if( length > static_cast<size_t>( output_end - output ) )
+			return 0;
+
+		const uint8_t *match = output - offset;
+		if( offset >= length )
+		{
+			std::memcpy( output, match, length );
+			output += length;
+		}
+		else
+		{
+			// overlapping copies repeat the last offset bytes
+			for( size_t k = 0; k < length; ++k )
+				output[k] = match[k];
+
+			output += length;
+		}
+	}
+
+	return static_cast<size_t>( output - destination );
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace xconsole
+{
+
+/*
+ A small, self-contained implementation of the LZ4 block format, so any LZ4
+ library can decompress what we produce. Only single blocks are supported,
+ the frame format and its checksums are left to our own protocol.
+ */
+
+/*!
+ \brief Return the worst case size of compressing the provided amount of
+ data.
+
+ \param size Size of the uncompressed data.
+
+ \return Maximum size of the compressed data.
+ */
+size_t Lz4CompressBound( size_t size );
+
+/*!
+ \brief Compresses blocks, reusing its match table between calls.
+ */
+class Lz4Encoder
+{
+public:
+	/*!
+	 \brief Compress a block.
+
+	 \param source Data to compress.
+	 \param size Size of the data, at most 2 GiB.
+	 \param destination Where to write the compressed data.
+	 \param capacity Size of the destination buffer.
+
+	 \return Size of the compressed data or 0 if it doesn't fit.
+	 */
+	size_t Compress( const uint8_t *source, size_t size, uint8_t *destination, size_t capacity );
+
+private:
+	static const int hash_bits = 12;
+
+	uint32_t table[1 << hash_bits];
+};
+
+/*!
+ \brief Decompress a block.
+
+ Malformed input is detected and never reads or writes out of bounds.
+
+ \param source Compressed data.
+ \param size Size of the compressed data.
+ \param destination Where to write the decompressed data.
+ \param capacity Size of the destination buffer.
+
+ \return Size of the decompressed data or 0 if the input is malformed or
+ doesn't fit.
+ */
+size_t Lz4Decompress( const uint8_t *source, size_t size, uint8_t *destination, size_t capacity );
+
+} // namespace xconsole
\ No newline at end of file
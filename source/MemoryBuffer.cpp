@@ -0,0 +1,162 @@
+/*************************************************************************
+ * MultiLibrary - danielga.bitbucket.org/multilibrary
+ * A C++ library that covers multiple low level systems.
+ *------------------------------------------------------------------------
+ * Copyright (c) 2015, Daniel Almeida
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************/
+
+#include <MemoryBuffer.hpp>
+#include <cassert>
+#include <cstring>
+
+namespace MultiLibrary
+{
+
+MemoryBuffer::MemoryBuffer( void *memory, size_t size ) :
+	buffer_memory( static_cast<uint8_t *>( memory ) ),
+	buffer_size( size ),
+	buffer_offset( 0 ),
+	end_of_file( false ),
+	clamped( false )
+{ }
+
+bool MemoryBuffer::IsValid( ) const
+{
+	return !clamped;
+}
+
+MemoryBuffer::operator bool( ) const
+{
+	return IsValid( );
+}
+
+bool MemoryBuffer::operator!( ) const
+{
+	return !IsValid( );
+}
+
+int64_t MemoryBuffer::Tell( ) const
+{
+	return static_cast<int64_t>( buffer_offset );
+}
+
+int64_t MemoryBuffer::Size( ) const
+{
+	return static_cast<int64_t>( buffer_size );
+}
+
+bool MemoryBuffer::Seek( int64_t position, SeekMode mode )
+{
+	int64_t temp;
+	switch( mode )
+	{
+	case SEEKMODE_SET:
+		temp = position;
+		break;
+
+	case SEEKMODE_CUR:
+		temp = Tell( ) + position;
+		break;
+
+	case SEEKMODE_END:
+		temp = Size( ) + position;
+		break;
+
+	default:
+		return false;
+	}
+
+	if( temp < 0 )
+		temp = 0;
+	else if( temp > Size( ) )
+		temp = Size( );
+
+	buffer_offset = static_cast<size_t>( temp );
+	end_of_file = false;
+	return true;
+}
+
+bool MemoryBuffer::EndOfFile( ) const
+{
+	return end_of_file;
+}
+
+uint8_t *MemoryBuffer::GetBuffer( )
+{
+	return buffer_memory;
+}
+
+const uint8_t *MemoryBuffer::GetBuffer( ) const
+{
+	return buffer_memory;
+}
+
+size_t MemoryBuffer::Read( void *value, size_t size )
+{
+	assert( value != nullptr && size != 0 );
+
+	size_t available = buffer_size - buffer_offset;
+	if( available < size )
+	{
+		end_of_file = true;
+		clamped = true;
+		size = available;
+	}
+
+	std::memcpy( value, buffer_memory + buffer_offset, size );
+	buffer_offset += size;
+	return size;
+}
+
+const uint8_t *MemoryBuffer::Peek( size_t &size ) const
+{
+	size = buffer_size - buffer_offset;
+	return buffer_memory + buffer_offset;
+}
+
+size_t MemoryBuffer::Write( const void *value, size_t size )
+{
+	assert( value != nullptr && size != 0 );
+
+	size_t available = buffer_size - buffer_offset;
+	if( available < size )
+	{
+		clamped = true;
+		size = available;
+	}
+
+	std::memcpy( buffer_memory + buffer_offset, value, size );
+	buffer_offset += size;
+	return size;
+}
+
+} // namespace MultiLibrary
\ No newline at end of file
@@ -0,0 +1,180 @@
+/*************************************************************************
+ * MultiLibrary - danielga.bitbucket.org/multilibrary
+ * A C++ library that covers multiple low level systems.
+ *------------------------------------------------------------------------
+ * Copyright (c) 2015, Daniel Almeida
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************/
+
+#pragma once
+
+#include <IOStream.hpp>
+
+namespace MultiLibrary
+{
+
+/*!
+ \brief A class that represents a fixed block of memory owned by someone else.
+
+ Works like ByteBuffer but never allocates, reads and writes are clamped to
+ the size of the block instead.
+ */
+class MemoryBuffer : public IOStream
+{
+public:
+	/*!
+	 \brief Create a buffer over the provided memory.
+
+	 \param memory Memory to read from and write to.
+	 \param size Size of the memory.
+	 */
+	MemoryBuffer( void *memory, size_t size );
+
+	/*!
+	 \brief Tell if the buffer is valid.
+
+	 A buffer stops being valid when a read or write is clamped.
+
+	 \return If no operation was clamped, true, otherwise false.
+	 */
+	bool IsValid( ) const;
+
+	/*!
+	 \brief Tell if the object is valid.
+
+	 Currently just returns the value of IsValid.
+
+	 \return A boolean type relative to IsValid.
+
+	 \sa IsValid
+	 */
+	explicit operator bool( ) const;
+
+	/*!
+	 \brief Tell if the object is not valid.
+
+	 Currently just returns the reverse of IsValid.
+
+	 \return Validness of this object.
+
+	 \sa IsValid
+	 */
+	bool operator!( ) const;
+
+	/*!
+	 \brief Return the current position on the buffer.
+
+	 \return Current position of read/write operations on the buffer.
+	 */
+	int64_t Tell( ) const;
+
+	/*!
+	 \brief Return the size of the buffer.
+
+	 \return Size of the buffer.
+	 */
+	int64_t Size( ) const;
+
+	/*!
+	 \brief Set the current position of read/write operations.
+
+	 The position is clamped to the size of the buffer.
+
+	 \param position Position to set the pointer to.
+	 \param mode (Optional) Type of seeking pretended.
+
+	 \return Success of this operation.
+	 */
+	bool Seek( int64_t position, SeekMode mode = SEEKMODE_SET );
+
+	/*!
+	 \brief Tell if the end of file was reached.
+
+	 In this case, end of file means we reached the end of the buffer.
+
+	 \return End of buffer reached.
+	 */
+	bool EndOfFile( ) const;
+
+	/*!
+	 \brief Return pointer to the memory.
+
+	 \return Pointer to the memory.
+	 */
+	uint8_t *GetBuffer( );
+
+	/*!
+	 \brief Return const pointer to the memory.
+
+	 \return Pointer to the memory.
+
+	 \overload
+	 */
+	const uint8_t *GetBuffer( ) const;
+
+	/*!
+	 \brief Read data from the buffer.
+
+	 \param value Pointer to the buffer to write to.
+	 \param size Amount to read.
+
+	 \return Size in bytes of the read data.
+	 */
+	size_t Read( void *value, size_t size );
+
+	/*!
+	 \brief Return the unread data of the buffer.
+
+	 \param size Where to store the amount of unread bytes.
+
+	 \return Pointer to the unread data.
+	 */
+	const uint8_t *Peek( size_t &size ) const;
+
+	/*!
+	 \brief Write data to the buffer.
+
+	 \param value Pointer to the data to write.
+	 \param size Size of the provided data.
+
+	 \return Size in bytes of the written data.
+	 */
+	size_t Write( const void *value, size_t size );
+
+private:
+	uint8_t *buffer_memory;
+	size_t buffer_size;
+	size_t buffer_offset;
+	bool end_of_file;
+	bool clamped;
+};
+
+} // namespace MultiLibrary
\ No newline at end of file
@@ -0,0 +1,490 @@
+#if defined _WIN32
+
+#include <NamedPipeTransport.hpp>
+#include <cassert>
+#include <cstring>
+
+namespace xconsole
+{
+
+static const ULONG_PTR wake_key = 1;
+static const ULONG_PTR shutdown_key = 2;
+static const ULONG max_entries = 32;
+
+// how long to wait before creating the next pipe instance after it failed
+static const int listen_backoff = 100;
+
+static void ResetOperation( PipeOperation &operation )
+{
+	std::memset( static_cast<OVERLAPPED *>( &operation ), 0, sizeof( OVERLAPPED ) );
+}
+
+NamedPipeConnection::NamedPipeConnection( HANDLE pipe ) :
+	client_pipe( pipe ),
+	write_pending( false ),
+	read_truncated( false ),
+	pending_operations( 0 )
+{
+	PipeOperation *operations[] = { &connect_operation, &read_operation, &write_operation };
+	for( PipeOperation *operation : operations )
+	{
+		ResetOperation( *operation );
+		operation->connection = this;
+	}
+}
+
+NamedPipeConnection::~NamedPipeConnection( )
+{
+	Cancel( );
+}
+
+Connection::Status NamedPipeConnection::Write( const void *data, size_t size )
+{
+	const MultiLibrary::IoVector vector = { data, size };
+	return WriteV( &vector, 1 );
+}
+
+Connection::Status NamedPipeConnection::WriteV( const MultiLibrary::IoVector *vectors, size_t count )
+{
+	assert( count <= max_write_vectors );
+
+	if( write_pending )
+		return STATUS_BLOCKED;
+
+	// the data must outlive the write, which can complete much later, so the
+	// pieces are gathered straight into the buffer that is written
+	write_buffer.clear( );
+	for( size_t k = 0; k < count; ++k )
+	{
+		const uint8_t *bytes = static_cast<const uint8_t *>( vectors[k].data );
+		write_buffer.insert( write_buffer.end( ), bytes, bytes + vectors[k].size );
+	}
+
+	ResetOperation( write_operation );
+	if( WriteFile(
+		client_pipe,
+		write_buffer.data( ),
+		static_cast<DWORD>( write_buffer.size( ) ),
+		nullptr,
+		&write_operation
+	) != FALSE )
+		return STATUS_OK;
+
+	if( GetLastError( ) != ERROR_IO_PENDING )
+		return STATUS_CLOSED;
+
+	write_pending = true;
+	++pending_operations;
+	return STATUS_OK;
+}
+
+bool NamedPipeConnection::BeginConnect( bool &connected )
+{
+	connected = false;
+
+	ResetOperation( connect_operation );
+	if( ConnectNamedPipe( client_pipe, &connect_operation ) != FALSE )
+	{
+		connected = true;
+		return true;
+	}
+
+	switch( GetLastError( ) )
+	{
+	case ERROR_IO_PENDING:
+		++pending_operations;
+		return true;
+
+	case ERROR_PIPE_CONNECTED:
+		connected = true;
+		return true;
+
+	default:
+		return false;
+	}
+}
+
+bool NamedPipeConnection::BeginRead( TransportHandler *handler )
+{
+	// reads that complete right away don't queue a completion, so keep
+	// reading until one is left pending
+	while( true )
+	{
+		ResetOperation( read_operation );
+		if( ReadFile(
+			client_pipe,
+			read_buffer,
+			sizeof( read_buffer ),
+			nullptr,
+			&read_operation
+		) != FALSE )
+		{
+			DWORD transferred = 0;
+			GetOverlappedResult( client_pipe, &read_operation, &transferred, FALSE );
+			if( read_truncated )
+				read_truncated = false;
+			else if( transferred != 0 )
+				handler->OnReceive( this, read_buffer, transferred );
+
+			continue;
+		}
+
+		switch( GetLastError( ) )
+		{
+		// reads of messages that don't fit didn't succeed, so they still
+		// queue a completion, which deals with them
+		case ERROR_MORE_DATA:
+		case ERROR_IO_PENDING:
+			++pending_operations;
+			return true;
+
+		default:
+			return false;
+		}
+	}
+}
+
+bool NamedPipeConnection::Complete( PipeOperation *operation, DWORD &transferred )
+{
+	--pending_operations;
+	if( operation == &write_operation )
+		write_pending = false;
+
+	transferred = 0;
+	if( client_pipe == INVALID_HANDLE_VALUE )
+		return false;
+
+	if( GetOverlappedResult( client_pipe, operation, &transferred, FALSE ) != FALSE )
+	{
+		// the end of a message that didn't fit
+		if( operation == &read_operation && read_truncated )
+		{
+			read_truncated = false;
+			transferred = 0;
+		}
+
+		return true;
+	}
+
+	// messages that don't fit are of no use to us, but aren't an error; the
+	// rest of them is read and thrown away before the next message
+	transferred = 0;
+	if( GetLastError( ) != ERROR_MORE_DATA )
+		return false;
+
+	read_truncated = true;
+	return true;
+}
+
+const uint8_t *NamedPipeConnection::GetReadBuffer( ) const
+{
+	return read_buffer;
+}
+
+void NamedPipeConnection::Cancel( )
+{
+	if( client_pipe == INVALID_HANDLE_VALUE )
+		return;
+
+	CancelIoEx( client_pipe, nullptr );
+	DisconnectNamedPipe( client_pipe );
+	CloseHandle( client_pipe );
+	client_pipe = INVALID_HANDLE_VALUE;
+}
+
+bool NamedPipeConnection::IsPending( ) const
+{
+	return pending_operations != 0;
+}
+
+bool NamedPipeConnection::IsWriteOperation( const PipeOperation *operation ) const
+{
+	return operation == &write_operation;
+}
+
+NamedPipeTransport::NamedPipeTransport( ) :
+	transport_handler( nullptr ),
+	completion_port( nullptr ),
+	listen_connection( nullptr ),
+	server_shutdown( false )
+{ }
+
+NamedPipeTransport::~NamedPipeTransport( )
+{
+	Close( );
+}
+
+bool NamedPipeTransport::Open( const std::string &path, TransportHandler *handler )
+{
+	completion_port = CreateIoCompletionPort( INVALID_HANDLE_VALUE, nullptr, 0, 1 );
+	if( completion_port == nullptr )
+		return false;
+
+	pipe_path = path;
+	transport_handler = handler;
+	server_shutdown = false;
+	if( !Listen( ) )
+	{
+		Close( );
+		return false;
+	}
+
+	return true;
+}
+
+void NamedPipeTransport::Close( )
+{
+	if( completion_port == nullptr )
+		return;
+
+	for( NamedPipeConnection *connection : connections )
+		Release( connection );
+
+	connections.clear( );
+
+	if( listen_connection != nullptr )
+	{
+		Release( listen_connection );
+		listen_connection = nullptr;
+	}
+
+	// cancelled operations still complete and reference their connections,
+	// so those can only be deleted afterwards
+	while( !closed_connections.empty( ) )
+	{
+		OVERLAPPED_ENTRY entries[max_entries];
+		ULONG count = 0;
+		if( GetQueuedCompletionStatusEx(
+			completion_port,
+			entries,
+			max_entries,
+			&count,
+			1000,
+			FALSE
+		) == FALSE )
+			break;
+
+		for( ULONG k = 0; k < count; ++k )
+		{
+			if( entries[k].lpOverlapped == nullptr )
+				continue;
+
+			PipeOperation *operation = static_cast<PipeOperation *>( entries[k].lpOverlapped );
+			NamedPipeConnection *connection = operation->connection;
+			DWORD transferred = 0;
+			connection->Complete( operation, transferred );
+			if( !connection->IsPending( ) && closed_connections.erase( connection ) != 0 )
+				delete connection;
+		}
+	}
+
+	// whatever is left has operations that never completed, deleting them
+	// could corrupt memory if they ever do
+	closed_connections.clear( );
+
+	CloseHandle( completion_port );
+	completion_port = nullptr;
+}
+
+bool NamedPipeTransport::Wait( int timeout )
+{
+	if( server_shutdown )
+		return false;
+
+	if( listen_connection == nullptr )
+		timeout = RetryListen( timeout );
+
+	OVERLAPPED_ENTRY entries[max_entries];
+	ULONG count = 0;
+	if( GetQueuedCompletionStatusEx(
+		completion_port,
+		entries,
+		max_entries,
+		&count,
+		timeout < 0 ? INFINITE : static_cast<DWORD>( timeout ),
+		FALSE
+	) == FALSE )
+		return true;
+
+	for( ULONG k = 0; k < count; ++k )
+	{
+		const OVERLAPPED_ENTRY &entry = entries[k];
+		if( entry.lpOverlapped == nullptr )
+		{
+			if( entry.lpCompletionKey == shutdown_key )
+				server_shutdown = true;
+
+			continue;
+		}
+
+		PipeOperation *operation = static_cast<PipeOperation *>( entry.lpOverlapped );
+		NamedPipeConnection *connection = operation->connection;
+		DWORD transferred = 0;
+		const bool succeeded = connection->Complete( operation, transferred );
+		if( closed_connections.find( connection ) != closed_connections.end( ) )
+		{
+			if( !connection->IsPending( ) )
+			{
+				closed_connections.erase( connection );
+				delete connection;
+			}
+
+			continue;
+		}
+
+		if( connection == listen_connection )
+		{
+			if( succeeded )
+				Accept( );
+			else
+			{
+				// the console went away before we got to it
+				Release( listen_connection );
+				listen_connection = nullptr;
+			}
+
+			// without a pipe instance no console can connect, so keep trying
+			if( !Listen( ) )
+				listen_retry = std::chrono::steady_clock::now( ) + std::chrono::milliseconds( listen_backoff );
+		}
+		else if( !succeeded )
+		{
+			transport_handler->OnDisconnect( connection );
+			Disconnect( connection );
+		}
+		else if( connection->IsWriteOperation( operation ) )
+			transport_handler->OnWritable( connection );
+		else
+		{
+			if( transferred != 0 )
+				transport_handler->OnReceive( connection, connection->GetReadBuffer( ), transferred );
+
+			if( connections.find( connection ) != connections.end( ) &&
+				!connection->BeginRead( transport_handler ) )
+			{
+				transport_handler->OnDisconnect( connection );
+				Disconnect( connection );
+			}
+		}
+	}
+
+	return !server_shutdown;
+}
+
+void NamedPipeTransport::Wake( )
+{
+	PostQueuedCompletionStatus( completion_port, 0, wake_key, nullptr );
+}
+
+void NamedPipeTransport::Shutdown( )
+{
+	PostQueuedCompletionStatus( completion_port, 0, shutdown_key, nullptr );
+}
+
+void NamedPipeTransport::Disconnect( Connection *connection )
+{
+	NamedPipeConnection *pipe_connection = static_cast<NamedPipeConnection *>( connection );
+	if( connections.erase( pipe_connection ) != 0 )
+		Release( pipe_connection );
+}
+
+bool NamedPipeTransport::Listen( )
+{
+	SECURITY_DESCRIPTOR sd;
+	InitializeSecurityDescriptor( &sd, SECURITY_DESCRIPTOR_REVISION );
+	SetSecurityDescriptorDacl( &sd, TRUE, nullptr, FALSE );
+
+	SECURITY_ATTRIBUTES sa;
+	sa.nLength = sizeof( sa );
+	sa.lpSecurityDescriptor = &sd;
+	sa.bInheritHandle = FALSE;
+
+	while( true )
+	{
+		HANDLE pipe = CreateNamedPipeA(
+			pipe_path.c_str( ),
+			PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+			PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT,
+			PIPE_UNLIMITED_INSTANCES,
+			8192,
+			8192,
+			NMPWAIT_USE_DEFAULT_WAIT,
+			&sa
+		);
+		if( pipe == INVALID_HANDLE_VALUE )
+			return false;
+
+		if( CreateIoCompletionPort( pipe, completion_port, 0, 0 ) == nullptr )
+		{
+			CloseHandle( pipe );
+			return false;
+		}
+
+		// operations that complete right away are handled on the spot, which
+		// would handle them twice if they also queued a completion
+		if( SetFileCompletionNotificationModes( pipe, FILE_SKIP_COMPLETION_PORT_ON_SUCCESS ) == FALSE )
+		{
+			CloseHandle( pipe );
+			return false;
+		}
+
+		bool connected = false;
+		listen_connection = new NamedPipeConnection( pipe );
+		if( !listen_connection->BeginConnect( connected ) )
+		{
+			Release( listen_connection );
+			listen_connection = nullptr;
+			return false;
+		}
+
+		if( !connected )
+			return true;
+
+		Accept( );
+	}
+}
+
+int NamedPipeTransport::RetryListen( int timeout )
+{
+	int remaining = static_cast<int>( std::chrono::duration_cast<std::chrono::milliseconds>(
+		listen_retry - std::chrono::steady_clock::now( )
+	).count( ) );
+	if( remaining <= 0 )
+	{
+		if( Listen( ) )
+			return timeout;
+
+		listen_retry = std::chrono::steady_clock::now( ) + std::chrono::milliseconds( listen_backoff );
+		remaining = listen_backoff;
+	}
+
+	return timeout < 0 || timeout > remaining ? remaining : timeout;
+}
+
+void NamedPipeTransport::Accept( )
+{
+	NamedPipeConnection *connection = listen_connection;
+	listen_connection = nullptr;
+
+	connections.insert( connection );
+	transport_handler->OnConnect( connection );
+	if( connections.find( connection ) != connections.end( ) &&
+		!connection->BeginRead( transport_handler ) )
+	{
+		transport_handler->OnDisconnect( connection );
+		Disconnect( connection );
+	}
+}
+
+void NamedPipeTransport::Release( NamedPipeConnection *connection )
+{
+	connection->Cancel( );
+	if( connection->IsPending( ) )
+		closed_connections.insert( connection );
+	else
+		delete connection;
+}
+
+} // namespace xconsole
+
+#endif
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+#if defined _WIN32
+
+#include <Transport.hpp>
+#include <Windows.h>
+#include <chrono>
+#include <cstdint>
+#include <set>
+#include <vector>
+
+namespace xconsole
+{
+
+class NamedPipeConnection;
+
+/*!
+ \brief An overlapped operation, tagged with the connection that issued it.
+ */
+struct PipeOperation : OVERLAPPED
+{
+	NamedPipeConnection *connection;
+};
+
+/*!
+ \brief Connection to a console through an instance of a named pipe.
+
+ All I/O is overlapped and completes on the transport's completion port.
+ At most one write is in flight at any time.
+ */
+class NamedPipeConnection : public Connection
+{
+public:
+	explicit NamedPipeConnection( HANDLE pipe );
+	~NamedPipeConnection( );
+
+	Status Write( const void *data, size_t size );
+	Status WriteV( const MultiLibrary::IoVector *vectors, size_t count );
+
+	/*!
+	 \brief Start waiting for a console to connect to this instance.
+
+	 \param connected Set to true if a console was already connected.
+
+	 \return false if it fails, true otherwise.
+	 */
+	bool BeginConnect( bool &connected );
+
+	/*!
+	 \brief Start a read, which completes when the console sends data or
+	 disconnects.
+
+	 \param handler Receives the messages of reads that complete right away.
+
+	 \return false if it fails, true otherwise.
+	 */
+	bool BeginRead( TransportHandler *handler );
+
+	/*!
+	 \brief Called when one of the operations of this connection completes.
+
+	 \param operation Operation that completed.
+	 \param transferred Set to the amount of bytes transferred.
+
+	 \return false if the operation failed, true otherwise.
+	 */
+	bool Complete( PipeOperation *operation, DWORD &transferred );
+
+	/*!
+	 \brief Return the data received by the last read.
+
+	 \return Pointer to the read buffer.
+	 */
+	const uint8_t *GetReadBuffer( ) const;
+
+	/*!
+	 \brief Cancel all operations and close the pipe.
+	 */
+	void Cancel( );
+
+	/*!
+	 \brief Tell if any operation of this connection hasn't completed yet.
+
+	 \return true if an operation is still pending, false otherwise.
+	 */
+	bool IsPending( ) const;
+
+	/*!
+	 \brief Tell if the provided operation is this connection's write.
+
+	 \param operation Operation to check.
+
+	 \return true if it is the write operation, false otherwise.
+	 */
+	bool IsWriteOperation( const PipeOperation *operation ) const;
+
+private:
+	HANDLE client_pipe;
+	PipeOperation connect_operation;
+	PipeOperation read_operation;
+	PipeOperation write_operation;
+	uint8_t read_buffer[max_receive_size];
+	std::vector<uint8_t> write_buffer;
+	bool write_pending;
+	bool read_truncated;
+	int pending_operations;
+};
+
+/*!
+ \brief Transport based on a Windows named pipe in message mode.
+
+ One pipe instance is always kept waiting for the next console. Waiting is
+ done on an I/O completion port, which also receives wake up and shutdown
+ notifications.
+ */
+class NamedPipeTransport : public Transport
+{
+public:
+	NamedPipeTransport( );
+	~NamedPipeTransport( );
+
+	bool Open( const std::string &path, TransportHandler *handler );
+	void Close( );
+	bool Wait( int timeout );
+	void Wake( );
+	void Shutdown( );
+	void Disconnect( Connection *connection );
+
+private:
+	bool Listen( );
+	int RetryListen( int timeout );
+	void Accept( );
+	void Release( NamedPipeConnection *connection );
+
+	std::string pipe_path;
+	TransportHandler *transport_handler;
+	HANDLE completion_port;
+	NamedPipeConnection *listen_connection;
+	std::chrono::steady_clock::time_point listen_retry;
+	bool server_shutdown;
+	std::set<NamedPipeConnection *> connections;
+	std::set<NamedPipeConnection *> closed_connections;
+};
+
+} // namespace xconsole
+
+#endif
\ No newline at end of file
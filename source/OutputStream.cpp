@@ -41,6 +41,18 @@
 namespace MultiLibrary
 {
 
+size_t OutputStream::WriteV( const IoVector *vectors, size_t count )
+{
+	assert( vectors != nullptr || count == 0 );
+
+	size_t written = 0;
+	for( size_t k = 0; k < count; ++k )
+		if( vectors[k].size != 0 )
+			written += Write( vectors[k].data, vectors[k].size );
+
+	return written;
+}
+
 OutputStream &OutputStream::operator<<( const bool &data )
 {
 	Write( &data, sizeof( bool ) );
@@ -42,6 +42,15 @@
 namespace MultiLibrary
 {
 
+/*!
+ \brief A piece of memory to write, part of a scatter-gather write.
+ */
+struct IoVector
+{
+	const void *data; ///< Start of the piece
+	size_t size; ///< Size of the piece
+};
+
 /*!
  \brief An abstract class for objects that can act as output data streams.
  */
@@ -58,6 +67,20 @@ public:
 	 */
 	virtual size_t Write( const void *data, size_t size ) = 0;
 
+	/*!
+	 \brief Writes several pieces of memory one after the other.
+
+	 Lets callers write a header followed by data they don't own without
+	 copying them together first. By default, each piece is written with
+	 Write.
+
+	 \param vectors Pieces to write.
+	 \param count Amount of pieces.
+
+	 \return Amount of written bytes.
+	 */
+	virtual size_t WriteV( const IoVector *vectors, size_t count );
+
 	/*!
 	 \brief Write data into the buffer from a variable.
 
@@ -0,0 +1,736 @@
+#include <Protocol.hpp>
+#include <MemoryBuffer.hpp>
+
+namespace xconsole
+{
+
+static_assert( SchemaOf<FrameHeader>::Type::size == frame_header_size, "frame header size changed" );
+static_assert( SchemaOf<RecordHeader>::Type::size == record_header_size, "record header size changed" );
+
+// the encoders used to build frames work on both streams and writers
+template<typename Stream>
+static void WriteFrameHeader( Stream &stream, uint8_t flags, uint32_t length )
+{
+	FrameHeader header;
+	header.magic = frame_magic;
+	header.version = protocol_version;
+	header.flags = flags;
+	header.length = length;
+	EncodeFields( stream, header );
+}
+
+// streams grow as they're written, writers can make room for a record at once
+static void ReserveRecord( MultiLibrary::OutputStream &, size_t )
+{ }
+
+static void ReserveRecord( BufferWriter &stream, size_t size )
+{
+	stream.Reserve( record_header_size + size );
+}
+
+template<typename Stream>
+static void WriteRecordHeader( Stream &stream, RecordKind kind, uint32_t length )
+{
+	RecordHeader header;
+	header.kind = static_cast<uint8_t>( kind );
+	header.length = length;
+	EncodeFields( stream, header );
+}
+
+void EncodeFrameHeader( MultiLibrary::OutputStream &stream, uint8_t flags, uint32_t length )
+{
+	WriteFrameHeader( stream, flags, length );
+}
+
+void EncodeFrameHeader( BufferWriter &stream, uint8_t flags, uint32_t length )
+{
+	WriteFrameHeader( stream, flags, length );
+}
+
+bool DecodeFrameHeader( MultiLibrary::InputStream &stream, FrameHeader &header )
+{
+	header.magic = 0;
+	header.version = 0;
+	header.flags = 0;
+	header.length = 0;
+	return DecodeFields( stream, header ) &&
+		header.magic == frame_magic && header.version == protocol_version;
+}
+
+bool DecodeFrameHeader( BufferView &view, FrameHeader &header )
+{
+	header.magic = 0;
+	header.version = 0;
+	header.flags = 0;
+	header.length = 0;
+	return DecodeFields( view, header ) &&
+		header.magic == frame_magic && header.version == protocol_version;
+}
+
+bool EncodeCompressedFrame(
+	MultiLibrary::ByteBuffer &stream,
+	const uint8_t *records,
+	size_t size,
+	Lz4Encoder &encoder
+)
+{
+	const size_t prefix = frame_header_size + sizeof( uint32_t );
+
+	// compress straight into the stream, only keeping it if it paid off
+	if( size <= sizeof( uint32_t ) )
+		return false;
+
+	const size_t capacity = size - sizeof( uint32_t );
+	uint8_t *frame = stream.Prepare( prefix + capacity );
+	const size_t compressed = encoder.Compress( records, size, frame + prefix, capacity );
+	if( compressed == 0 )
+	{
+		stream.Commit( 0 );
+		return false;
+	}
+
+	MultiLibrary::MemoryBuffer header( frame, prefix );
+	EncodeFrameHeader(
+		header,
+		FRAME_COMPRESSED,
+		static_cast<uint32_t>( sizeof( uint32_t ) + compressed )
+	);
+	header << static_cast<uint32_t>( size );
+	stream.Commit( prefix + compressed );
+	return true;
+}
+
+bool DecodeFrame(
+	MultiLibrary::InputStream &stream,
+	FrameHeader &header,
+	MultiLibrary::ByteBuffer &records,
+	size_t max_size
+)
+{
+	if( !DecodeFrameHeader( stream, header ) )
+		return false;
+
+	records.Clear( );
+	if( header.length == 0 )
+		return true;
+
+	// lengths come from the other end, nothing is allocated until they check out
+	const int64_t remaining = stream.Size( ) - stream.Tell( );
+	if( remaining < 0 || static_cast<uint64_t>( header.length ) > static_cast<uint64_t>( remaining ) )
+		return false;
+
+	if( ( header.flags & FRAME_COMPRESSED ) == 0 )
+	{
+		if( header.length > max_size )
+			return false;
+
+		uint8_t *data = records.Prepare( header.length );
+		if( stream.Read( data, header.length ) != header.length )
+			return false;
+
+		records.Commit( header.length );
+		records.Seek( 0 );
+		return true;
+	}
+
+	uint32_t size = 0;
+	stream >> size;
+	if( stream.EndOfFile( ) || header.length < sizeof( size ) || size > max_size )
+		return false;
+
+	const size_t compressed_size = header.length - sizeof( size );
+	MultiLibrary::ByteBuffer compressed( compressed_size );
+	if( compressed_size != 0 &&
+		stream.Read( compressed.GetBuffer( ), compressed_size ) != compressed_size )
+		return false;
+
+	if( size == 0 )
+		return true;
+
+	uint8_t *data = records.Prepare( size );
+	if( Lz4Decompress( compressed.GetBuffer( ), compressed_size, data, size ) != size )
+		return false;
+
+	records.Commit( size );
+	records.Seek( 0 );
+	return true;
+}
+
+void EncodeRecordHeader( MultiLibrary::OutputStream &stream, RecordKind kind, uint32_t length )
+{
+	WriteRecordHeader( stream, kind, length );
+}
+
+void EncodeRecordHeader( BufferWriter &stream, RecordKind kind, uint32_t length )
+{
+	WriteRecordHeader( stream, kind, length );
+}
+
+bool DecodeRecordHeader( MultiLibrary::InputStream &stream, RecordHeader &header )
+{
+	header.kind = 0;
+	header.length = 0;
+	return DecodeFields( stream, header ) && header.kind != 0;
+}
+
+bool SkipRecord( MultiLibrary::InputStream &stream, const RecordHeader &header )
+{
+	return stream.Seek( header.length, MultiLibrary::SEEKMODE_CUR ) &&
+		stream.Tell( ) <= stream.Size( );
+}
+
+bool DecodeRecordHeader( BufferView &view, RecordHeader &header )
+{
+	header.kind = 0;
+	header.length = 0;
+	return DecodeFields( view, header ) && header.kind != 0;
+}
+
+bool SkipRecord( BufferView &view, const RecordHeader &header )
+{
+	return view.Skip( header.length );
+}
+
+SpewState::SpewState( )
+{
+	Reset( );
+}
+
+void SpewState::Reset( )
+{
+	valid = false;
+	type = 0;
+	level = 0;
+	group = 0;
+	color = 0;
+	sequence = 0;
+	time = 0;
+}
+
+template<typename Stream>
+static void WriteSpewRecord(
+	Stream &stream,
+	SpewState &state,
+	int32_t type,
+	int32_t level,
+	uint32_t group,
+	int32_t color,
+	uint64_t sequence,
+	uint64_t time,
+	const char *message,
+	size_t message_length
+)
+{
+	uint8_t fields = SPEW_FIELD_ALL;
+	if( state.valid )
+	{
+		fields = 0;
+		if( type != state.type )
+			fields |= SPEW_FIELD_TYPE;
+
+		if( level != state.level )
+			fields |= SPEW_FIELD_LEVEL;
+
+		if( group != state.group )
+			fields |= SPEW_FIELD_GROUP;
+
+		if( color != state.color )
+			fields |= SPEW_FIELD_COLOR;
+
+		if( sequence != state.sequence + 1 )
+			fields |= SPEW_FIELD_SEQUENCE;
+
+		// records from other threads can be slightly older than the previous one
+		if( time < state.time || time - state.time > UINT32_MAX )
+			fields |= SPEW_FIELD_TIME;
+	}
+
+	size_t size = sizeof( fields ) + message_length;
+	for( uint8_t field = SPEW_FIELD_TYPE; field <= SPEW_FIELD_COLOR; field <<= 1 )
+		if( ( fields & field ) != 0 )
+			size += sizeof( int32_t );
+
+	if( ( fields & SPEW_FIELD_SEQUENCE ) != 0 )
+		size += sizeof( sequence );
+
+	size += ( fields & SPEW_FIELD_TIME ) != 0 ? sizeof( time ) : sizeof( uint32_t );
+
+	ReserveRecord( stream, size );
+	WriteRecordHeader( stream, RECORD_SPEW, static_cast<uint32_t>( size ) );
+	stream << fields;
+	if( ( fields & SPEW_FIELD_TYPE ) != 0 )
+		stream << type;
+
+	if( ( fields & SPEW_FIELD_LEVEL ) != 0 )
+		stream << level;
+
+	if( ( fields & SPEW_FIELD_GROUP ) != 0 )
+		stream << group;
+
+	if( ( fields & SPEW_FIELD_COLOR ) != 0 )
+		stream << color;
+
+	if( ( fields & SPEW_FIELD_SEQUENCE ) != 0 )
+		stream << sequence;
+
+	if( ( fields & SPEW_FIELD_TIME ) != 0 )
+		stream << time;
+	else
+		stream << static_cast<uint32_t>( time - state.time );
+
+	// the record length already delimits the message
+	if( message_length != 0 )
+		stream.Write( message, message_length );
+
+	state.valid = true;
+	state.type = type;
+	state.level = level;
+	state.group = group;
+	state.color = color;
+	state.sequence = sequence;
+	state.time = time;
+}
+
+void EncodeSpewRecord(
+	MultiLibrary::OutputStream &stream,
+	SpewState &state,
+	int32_t type,
+	int32_t level,
+	uint32_t group,
+	int32_t color,
+	uint64_t sequence,
+	uint64_t time,
+	const char *message,
+	size_t message_length
+)
+{
+	WriteSpewRecord( stream, state, type, level, group, color, sequence, time, message, message_length );
+}
+
+void EncodeSpewRecord(
+	BufferWriter &stream,
+	SpewState &state,
+	int32_t type,
+	int32_t level,
+	uint32_t group,
+	int32_t color,
+	uint64_t sequence,
+	uint64_t time,
+	const char *message,
+	size_t message_length
+)
+{
+	WriteSpewRecord( stream, state, type, level, group, color, sequence, time, message, message_length );
+}
+
+// the spew decoders share everything but how the message is read
+template<typename Stream, typename Record>
+static bool ReadSpewFields( Stream &stream, const SpewState &state, Record &record )
+{
+	uint8_t fields = 0;
+	stream >> fields;
+
+	// the first record of a frame must carry every field
+	if( !state.valid && ( fields & SPEW_FIELD_ALL ) != SPEW_FIELD_ALL )
+		return false;
+
+	record.type = state.type;
+	record.level = state.level;
+	record.group = state.group;
+	record.color = state.color;
+	if( ( fields & SPEW_FIELD_TYPE ) != 0 )
+		stream >> record.type;
+
+	if( ( fields & SPEW_FIELD_LEVEL ) != 0 )
+		stream >> record.level;
+
+	if( ( fields & SPEW_FIELD_GROUP ) != 0 )
+		stream >> record.group;
+
+	if( ( fields & SPEW_FIELD_COLOR ) != 0 )
+		stream >> record.color;
+
+	record.sequence = state.sequence + 1;
+	if( ( fields & SPEW_FIELD_SEQUENCE ) != 0 )
+		stream >> record.sequence;
+
+	if( ( fields & SPEW_FIELD_TIME ) != 0 )
+		stream >> record.time;
+	else
+	{
+		uint32_t delta = 0;
+		stream >> delta;
+		record.time = state.time + delta;
+	}
+
+	return true;
+}
+
+template<typename Record>
+static void KeepSpewState( SpewState &state, const Record &record )
+{
+	state.valid = true;
+	state.type = record.type;
+	state.level = record.level;
+	state.group = record.group;
+	state.color = record.color;
+	state.sequence = record.sequence;
+	state.time = record.time;
+}
+
+bool DecodeSpewRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	SpewState &state,
+	SpewRecord &record
+)
+{
+	const int64_t start = stream.Tell( );
+	if( !ReadSpewFields( stream, state, record ) )
+		return false;
+
+	const int64_t consumed = stream.Tell( ) - start;
+	if( stream.EndOfFile( ) || consumed > header.length )
+		return false;
+
+	record.message.resize( static_cast<size_t>( header.length - consumed ) );
+	if( !record.message.empty( ) &&
+		stream.Read( &record.message[0], record.message.size( ) ) != record.message.size( ) )
+		return false;
+
+	KeepSpewState( state, record );
+	return true;
+}
+
+bool DecodeSpewRecord(
+	BufferView &view,
+	const RecordHeader &header,
+	SpewState &state,
+	SpewRecordView &record
+)
+{
+	BufferView body;
+	if( !view.ReadView( header.length, body ) || !ReadSpewFields( body, state, record ) ||
+		!body.IsValid( ) )
+		return false;
+
+	// the message is whatever is left of the record
+	body.ReadString( body.Remaining( ), record.message );
+	KeepSpewState( state, record );
+	return true;
+}
+
+void EncodeGroupRecord(
+	MultiLibrary::OutputStream &stream,
+	uint32_t group,
+	const char *name,
+	size_t length
+)
+{
+	EncodeRecordHeader( stream, RECORD_GROUP, static_cast<uint32_t>( sizeof( group ) + length ) );
+	stream << group;
+	if( length != 0 )
+		stream.Write( name, length );
+}
+
+bool DecodeGroupRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	uint32_t &group,
+	std::string &name
+)
+{
+	if( header.length < sizeof( group ) )
+		return false;
+
+	group = 0;
+	stream >> group;
+	name.resize( header.length - sizeof( group ) );
+	if( !name.empty( ) && stream.Read( &name[0], name.size( ) ) != name.size( ) )
+		return false;
+
+	return !stream.EndOfFile( );
+}
+
+bool DecodeGroupRecord(
+	BufferView &view,
+	const RecordHeader &header,
+	uint32_t &group,
+	StringView &name
+)
+{
+	BufferView body;
+	if( !view.ReadView( header.length, body ) )
+		return false;
+
+	group = 0;
+	body >> group;
+	return body.ReadString( body.Remaining( ), name ) && body.IsValid( );
+}
+
+HelloRecord::HelloRecord( ) :
+	features( 0 ),
+	has_policy( false ),
+	policy( POLICY_DROP_NEWEST ),
+	budget( 0 ),
+	parameter( 0 )
+{ }
+
+void EncodeHelloRecord( MultiLibrary::OutputStream &stream, const HelloRecord &record )
+{
+	uint32_t length = sizeof( record.features );
+	if( record.has_policy )
+		length += sizeof( record.policy ) + sizeof( record.budget ) + sizeof( record.parameter );
+
+	EncodeRecordHeader( stream, RECORD_HELLO, length );
+	stream << record.features;
+	if( record.has_policy )
+		stream << record.policy << record.budget << record.parameter;
+}
+
+bool DecodeHelloRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	HelloRecord &record
+)
+{
+	const uint32_t policy_length =
+		sizeof( record.policy ) + sizeof( record.budget ) + sizeof( record.parameter );
+
+	record = HelloRecord( );
+	if( header.length < sizeof( record.features ) )
+		return false;
+
+	stream >> record.features;
+	uint32_t consumed = sizeof( record.features );
+	if( header.length >= consumed + policy_length )
+	{
+		record.has_policy = true;
+		stream >> record.policy >> record.budget >> record.parameter;
+		consumed += policy_length;
+	}
+
+	// newer versions can append fields, which we skip
+	return !stream.EndOfFile( ) &&
+		stream.Seek( header.length - consumed, MultiLibrary::SEEKMODE_CUR );
+}
+
+template<typename Stream>
+static void WriteGapRecord( Stream &stream, uint64_t records )
+{
+	WriteRecordHeader( stream, RECORD_GAP, sizeof( records ) );
+	stream << records;
+}
+
+void EncodeGapRecord( MultiLibrary::OutputStream &stream, uint64_t records )
+{
+	WriteGapRecord( stream, records );
+}
+
+void EncodeGapRecord( BufferWriter &stream, uint64_t records )
+{
+	WriteGapRecord( stream, records );
+}
+
+bool DecodeGapRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	uint64_t &records
+)
+{
+	records = 0;
+	stream >> records;
+	return header.length >= sizeof( records ) && !stream.EndOfFile( ) &&
+		stream.Seek( header.length - sizeof( records ), MultiLibrary::SEEKMODE_CUR );
+}
+
+bool DecodeGapRecord(
+	BufferView &view,
+	const RecordHeader &header,
+	uint64_t &records
+)
+{
+	BufferView body;
+	if( !view.ReadView( header.length, body ) )
+		return false;
+
+	records = 0;
+	body >> records;
+	return body.IsValid( );
+}
+
+static size_t StringSize( const std::string &value )
+{
+	return sizeof( uint16_t ) + value.size( );
+}
+
+static void WriteString( MultiLibrary::OutputStream &stream, const std::string &value )
+{
+	stream << static_cast<uint16_t>( value.size( ) );
+	if( !value.empty( ) )
+		stream.Write( value.data( ), value.size( ) );
+}
+
+static bool ReadString( MultiLibrary::InputStream &stream, std::string &value )
+{
+	uint16_t length = 0;
+	stream >> length;
+	value.resize( length );
+	return !stream.EndOfFile( ) &&
+		( length == 0 || stream.Read( &value[0], length ) == length );
+}
+
+SubscribeRecord::SubscribeRecord( ) :
+	type_mask( 0xFFFFFFFF ),
+	min_level( INT32_MIN ),
+	pattern_kind( PATTERN_NONE )
+{ }
+
+bool SubscribeRecord::IsEverything( ) const
+{
+	return type_mask == 0xFFFFFFFF && min_level == INT32_MIN && allow_groups.empty( ) &&
+		deny_groups.empty( ) && ( pattern_kind == PATTERN_NONE || pattern.empty( ) );
+}
+
+bool SubscribeRecord::operator==( const SubscribeRecord &other ) const
+{
+	return type_mask == other.type_mask && min_level == other.min_level &&
+		allow_groups == other.allow_groups && deny_groups == other.deny_groups &&
+		pattern_kind == other.pattern_kind && pattern == other.pattern;
+}
+
+void EncodeSubscribeRecord( MultiLibrary::OutputStream &stream, const SubscribeRecord &record )
+{
+	size_t length = sizeof( record.type_mask ) + sizeof( record.min_level ) +
+		sizeof( uint16_t ) * 2 + sizeof( record.pattern_kind ) + StringSize( record.pattern );
+	for( const std::string &group : record.allow_groups )
+		length += StringSize( group );
+
+	for( const std::string &group : record.deny_groups )
+		length += StringSize( group );
+
+	EncodeRecordHeader( stream, RECORD_SUBSCRIBE, static_cast<uint32_t>( length ) );
+	stream << record.type_mask << record.min_level;
+	stream << static_cast<uint16_t>( record.allow_groups.size( ) );
+	for( const std::string &group : record.allow_groups )
+		WriteString( stream, group );
+
+	stream << static_cast<uint16_t>( record.deny_groups.size( ) );
+	for( const std::string &group : record.deny_groups )
+		WriteString( stream, group );
+
+	stream << record.pattern_kind;
+	WriteString( stream, record.pattern );
+}
+
+bool DecodeSubscribeRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	SubscribeRecord &record
+)
+{
+	const int64_t start = stream.Tell( );
+	record = SubscribeRecord( );
+	stream >> record.type_mask >> record.min_level;
+
+	std::vector<std::string> *lists[] = { &record.allow_groups, &record.deny_groups };
+	for( std::vector<std::string> *list : lists )
+	{
+		uint16_t count = 0;
+		stream >> count;
+		if( stream.EndOfFile( ) )
+			return false;
+
+		list->resize( count );
+		for( std::string &group : *list )
+			if( !ReadString( stream, group ) )
+				return false;
+	}
+
+	stream >> record.pattern_kind;
+	if( !ReadString( stream, record.pattern ) )
+		return false;
+
+	// newer versions can append fields, which we skip
+	const int64_t consumed = stream.Tell( ) - start;
+	if( consumed > header.length )
+		return false;
+
+	return stream.Seek( header.length - consumed, MultiLibrary::SEEKMODE_CUR );
+}
+
+void EncodeStatsRecord( MultiLibrary::OutputStream &stream, const StatsRecord &record )
+{
+	static const size_t bucket_size = sizeof( uint64_t ) * 2;
+	static const size_t client_size = sizeof( uint32_t ) + sizeof( uint64_t ) * 2 + sizeof( uint8_t );
+
+	size_t length = sizeof( uint8_t ) * 2 + sizeof( uint64_t ) * record.counters.size( ) +
+		sizeof( uint16_t ) + client_size * record.clients.size( );
+	for( const std::vector<LatencyBucket> &histogram : record.histograms )
+		length += sizeof( uint8_t ) + bucket_size * histogram.size( );
+
+	EncodeRecordHeader( stream, RECORD_STATS, static_cast<uint32_t>( length ) );
+	stream << static_cast<uint8_t>( record.counters.size( ) );
+	for( uint64_t counter : record.counters )
+		stream << counter;
+
+	stream << static_cast<uint8_t>( STATS_HISTOGRAM_COUNT );
+	for( const std::vector<LatencyBucket> &histogram : record.histograms )
+	{
+		stream << static_cast<uint8_t>( histogram.size( ) );
+		for( const LatencyBucket &bucket : histogram )
+			stream << bucket.limit << bucket.count;
+	}
+
+	stream << static_cast<uint16_t>( record.clients.size( ) );
+	for( const ClientStats &client : record.clients )
+		stream << client.queued_frames << client.queued_bytes << client.dropped << client.policy;
+}
+
+bool DecodeStatsRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	StatsRecord &record
+)
+{
+	const int64_t start = stream.Tell( );
+	record = StatsRecord( );
+
+	// newer versions can add counters and histograms, which are kept or skipped
+	uint8_t counter_count = 0;
+	stream >> counter_count;
+	record.counters.resize( counter_count );
+	for( uint64_t &counter : record.counters )
+		stream >> counter;
+
+	uint8_t histogram_count = 0;
+	stream >> histogram_count;
+	for( uint8_t k = 0; k < histogram_count && !stream.EndOfFile( ); ++k )
+	{
+		uint8_t bucket_count = 0;
+		stream >> bucket_count;
+		std::vector<LatencyBucket> buckets( bucket_count );
+		for( LatencyBucket &bucket : buckets )
+			stream >> bucket.limit >> bucket.count;
+
+		if( k < STATS_HISTOGRAM_COUNT )
+			record.histograms[k].swap( buckets );
+	}
+
+	uint16_t client_count = 0;
+	stream >> client_count;
+	if( stream.EndOfFile( ) )
+		return false;
+
+	record.clients.resize( client_count );
+	for( ClientStats &client : record.clients )
+		stream >> client.queued_frames >> client.queued_bytes >> client.dropped >> client.policy;
+
+	const int64_t consumed = stream.Tell( ) - start;
+	if( stream.EndOfFile( ) || consumed > header.length )
+		return false;
+
+	return stream.Seek( header.length - consumed, MultiLibrary::SEEKMODE_CUR );
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,709 @@
+#pragma once
+
+#include <BufferView.hpp>
+#include <ByteBuffer.hpp>
+#include <InputStream.hpp>
+#include <OutputStream.hpp>
+#include <Lz4.hpp>
+#include <Schema.hpp>
+#include <Writer.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace xconsole
+{
+
+/*
+ Everything sent to consoles is packed into frames. Each frame starts with a
+ header, followed by any number of records:
+
+ frame header: uint32 magic, uint8 version, uint8 flags, uint32 length
+ record header: uint8 kind, uint32 length
+
+ Lengths count the bytes after their header. All values are little endian.
+ Records of unknown kinds can be skipped by their length.
+
+ Spew records only carry the fields that changed since the previous spew
+ record of the same frame, and refer to groups by identifiers which are
+ defined by group records sent beforehand. Their sequence number is left out
+ when it follows the previous one, and their timestamp is sent as a 32-bit
+ delta when it fits.
+
+ Consoles can send frames too, to ask for optional features with a hello
+ record. Compressed frames hold the uint32 length of their records followed
+ by the records as a LZ4 block.
+ */
+
+static const uint32_t frame_magic = 0x4E4F4358; // "XCON"
+static const uint8_t protocol_version = 3;
+static const size_t frame_header_size = 10;
+static const size_t record_header_size = 5;
+
+/*!
+ \brief Values that represent the kinds of records.
+ */
+enum RecordKind
+{
+	RECORD_SPEW = 1, ///< A line of console output
+	RECORD_GROUP, ///< Definition of a spew group identifier
+	RECORD_HELLO, ///< Features requested by a console
+	RECORD_GAP, ///< Amount of records a console missed
+	RECORD_HISTORY_END, ///< End of the output from before a console connected
+	RECORD_SUBSCRIBE, ///< Records a console wants to receive
+	RECORD_STATS ///< Request for statistics, or the statistics themselves
+};
+
+/*!
+ \brief Flags of a frame header.
+ */
+enum FrameFlag
+{
+	FRAME_COMPRESSED = 1 << 0 ///< The records are compressed
+};
+
+/*!
+ \brief Optional features a console can ask for.
+ */
+enum Feature
+{
+	FEATURE_COMPRESSION = 1 << 0 ///< Frames can be compressed
+};
+
+/*!
+ \brief Flags that tell which fields a spew record carries.
+ */
+enum SpewField
+{
+	SPEW_FIELD_TYPE = 1 << 0,
+	SPEW_FIELD_LEVEL = 1 << 1,
+	SPEW_FIELD_GROUP = 1 << 2,
+	SPEW_FIELD_COLOR = 1 << 3,
+	SPEW_FIELD_SEQUENCE = 1 << 4, ///< Otherwise the sequence number follows the previous one
+	SPEW_FIELD_TIME = 1 << 5, ///< Otherwise a uint32 delta from the previous time is sent
+	SPEW_FIELD_ALL = SPEW_FIELD_TYPE | SPEW_FIELD_LEVEL | SPEW_FIELD_GROUP | SPEW_FIELD_COLOR |
+		SPEW_FIELD_SEQUENCE | SPEW_FIELD_TIME
+};
+
+/*!
+ \brief What to do with new frames when a console doesn't keep up.
+ */
+enum BackpressurePolicy
+{
+	POLICY_DROP_NEWEST, ///< Drop new frames once the budget is used up
+	POLICY_DROP_OLDEST, ///< Drop the oldest queued frames to make room
+	POLICY_BLOCK, ///< Hold the server for a while, then drop new frames
+	POLICY_SAMPLE, ///< Keep one in every few frames while behind
+	POLICY_COUNT
+};
+
+/*!
+ \brief How the pattern of a subscription is matched against messages.
+ */
+enum PatternKind
+{
+	PATTERN_NONE, ///< Every message matches
+	PATTERN_SUBSTRING, ///< Messages that contain the pattern match
+	PATTERN_REGEX, ///< Messages with a match of the ECMAScript regular expression
+	PATTERN_COUNT
+};
+
+/*!
+ \brief Counters of a stats record.
+ */
+enum StatsCounter
+{
+	STATS_RECORDS, ///< Records captured
+	STATS_RECORD_BYTES, ///< Bytes of captured messages
+	STATS_QUEUE_DROPS, ///< Records the queue had no room for
+	STATS_CLIENT_DROPS, ///< Records lost by consoles that fell behind
+	STATS_FRAMES, ///< Frames written to consoles
+	STATS_FRAME_BYTES, ///< Bytes written to consoles
+	STATS_CONNECTS, ///< Consoles that connected
+	STATS_DISCONNECTS, ///< Consoles that disconnected
+	STATS_BLOCKED_WRITES, ///< Writes that found a console's buffers full
+	STATS_WRITE_ERRORS, ///< Writes that failed, closing the connection
+	STATS_FILTER_ERRORS, ///< Regular expression matches that gave up, not letting the record through
+	STATS_COUNTER_COUNT
+};
+
+/*!
+ \brief Latency histograms of a stats record.
+ */
+enum StatsHistogram
+{
+	STATS_ENCODE, ///< Turning a captured record into frames, on the writer thread
+	STATS_ENQUEUE, ///< Capturing a record, which is all the game thread waits for
+	STATS_WRITE, ///< Writing a frame to a console
+	STATS_HISTOGRAM_COUNT
+};
+
+/*!
+ \brief Header that starts every frame.
+ */
+struct FrameHeader
+{
+	uint32_t magic;
+	uint8_t version;
+	uint8_t flags;
+	uint32_t length;
+};
+
+/*!
+ \brief Header that starts every record.
+ */
+struct RecordHeader
+{
+	uint8_t kind;
+	uint32_t length;
+};
+
+template<>
+struct SchemaOf<FrameHeader>
+{
+	typedef Schema<
+		Field<FrameHeader, uint32_t, &FrameHeader::magic>,
+		Field<FrameHeader, uint8_t, &FrameHeader::version>,
+		Field<FrameHeader, uint8_t, &FrameHeader::flags>,
+		Field<FrameHeader, uint32_t, &FrameHeader::length>
+	> Type;
+};
+
+template<>
+struct SchemaOf<RecordHeader>
+{
+	typedef Schema<
+		Field<RecordHeader, uint8_t, &RecordHeader::kind>,
+		Field<RecordHeader, uint32_t, &RecordHeader::length>
+	> Type;
+};
+
+/*!
+ \brief Fields of the previous spew record in a frame, which the next one is
+ delta encoded against.
+ */
+struct SpewState
+{
+	SpewState( );
+
+	/*!
+	 \brief Forget the previous record, done at the start of every frame.
+	 */
+	void Reset( );
+
+	bool valid;
+	int32_t type;
+	int32_t level;
+	uint32_t group;
+	int32_t color;
+	uint64_t sequence;
+	uint64_t time;
+};
+
+/*!
+ \brief Contents of a RECORD_HELLO record.
+ */
+struct HelloRecord
+{
+	HelloRecord( );
+
+	uint32_t features; ///< Combination of Feature values
+	bool has_policy; ///< Whether the fields below were sent
+	uint8_t policy; ///< BackpressurePolicy value
+	uint32_t budget; ///< Bytes that can be queued, 0 for the server default
+	uint32_t parameter; ///< Block timeout in milliseconds or sample rate
+};
+
+/*!
+ \brief Contents of a RECORD_SUBSCRIBE record.
+ */
+struct SubscribeRecord
+{
+	SubscribeRecord( );
+
+	/*!
+	 \brief Tell if this subscription lets every record through.
+
+	 \return true if nothing is filtered, false otherwise.
+	 */
+	bool IsEverything( ) const;
+
+	bool operator==( const SubscribeRecord &other ) const;
+
+	uint32_t type_mask; ///< Bit N set lets spew type N through
+	int32_t min_level; ///< Records below this level are filtered
+	std::vector<std::string> allow_groups; ///< Groups to let through, empty for all
+	std::vector<std::string> deny_groups; ///< Groups to filter
+	uint8_t pattern_kind; ///< PatternKind value
+	std::string pattern; ///< Pattern messages must match
+};
+
+/*!
+ \brief Bucket of a latency histogram.
+ */
+struct LatencyBucket
+{
+	uint64_t limit; ///< Nanoseconds every value of the bucket is below
+	uint64_t count; ///< Amount of values
+};
+
+/*!
+ \brief State of a connected console.
+ */
+struct ClientStats
+{
+	uint32_t queued_frames; ///< Frames waiting to be written
+	uint64_t queued_bytes; ///< Bytes waiting to be written
+	uint64_t dropped; ///< Records lost so far
+	uint8_t policy; ///< BackpressurePolicy value
+};
+
+/*!
+ \brief Contents of a RECORD_STATS record sent by the server.
+ */
+struct StatsRecord
+{
+	std::vector<uint64_t> counters; ///< Indexed by StatsCounter
+	std::vector<LatencyBucket> histograms[STATS_HISTOGRAM_COUNT]; ///< Buckets that aren't empty
+	std::vector<ClientStats> clients;
+};
+
+/*!
+ \brief Contents of a RECORD_SPEW record.
+ */
+struct SpewRecord
+{
+	int32_t type;
+	int32_t level;
+	uint32_t group;
+	int32_t color;
+	uint64_t sequence; ///< Position in the order records were captured
+	uint64_t time; ///< Monotonic capture time, in nanoseconds
+	std::string message;
+};
+
+/*!
+ \brief Contents of a RECORD_SPEW record, referring to the decoded memory.
+ */
+struct SpewRecordView
+{
+	int32_t type;
+	int32_t level;
+	uint32_t group;
+	int32_t color;
+	uint64_t sequence; ///< Position in the order records were captured
+	uint64_t time; ///< Monotonic capture time, in nanoseconds
+	StringView message; ///< Only valid while the decoded memory is
+};
+
+/*!
+ \brief Write a frame header.
+
+ \param stream Stream to write to.
+ \param flags Frame flags.
+ \param length Length of the records in the frame.
+ */
+void EncodeFrameHeader( MultiLibrary::OutputStream &stream, uint8_t flags, uint32_t length );
+
+/*!
+ \brief Write a frame header.
+
+ \param stream Writer to write to.
+ \param flags Frame flags.
+ \param length Length of the records in the frame.
+
+ \overload
+ */
+void EncodeFrameHeader( BufferWriter &stream, uint8_t flags, uint32_t length );
+
+/*!
+ \brief Read a frame header.
+
+ \param stream Stream to read from.
+ \param header Where to store the header.
+
+ \return false if the header is truncated or not recognized, true otherwise.
+ */
+bool DecodeFrameHeader( MultiLibrary::InputStream &stream, FrameHeader &header );
+
+/*!
+ \brief Read a frame header.
+
+ \param view View to read from.
+ \param header Where to store the header.
+
+ \return false if the header is truncated or not recognized, true otherwise.
+
+ \overload
+ */
+bool DecodeFrameHeader( BufferView &view, FrameHeader &header );
+
+/*!
+ \brief Write a compressed frame.
+
+ \param stream Stream to write to.
+ \param records Records of the frame.
+ \param size Size of the records.
+ \param encoder Encoder to compress with.
+
+ \return false if compressing doesn't make the frame any smaller, in which
+ case nothing is written, true otherwise.
+ */
+bool EncodeCompressedFrame(
+	MultiLibrary::ByteBuffer &stream,
+	const uint8_t *records,
+	size_t size,
+	Lz4Encoder &encoder
+);
+
+/*!
+ \brief Read a whole frame, decompressing it if needed.
+
+ The frame must be entirely in the stream, its length is checked against
+ what is left before anything is allocated.
+
+ \param stream Stream to read from.
+ \param header Where to store the header.
+ \param records Where to store the records of the frame.
+ \param max_size Largest size the records can have once decompressed.
+
+ \return false if the frame is truncated, too large or not recognized, true
+ otherwise.
+ */
+bool DecodeFrame(
+	MultiLibrary::InputStream &stream,
+	FrameHeader &header,
+	MultiLibrary::ByteBuffer &records,
+	size_t max_size
+);
+
+/*!
+ \brief Write a record header.
+
+ \param stream Stream to write to.
+ \param kind Kind of the record.
+ \param length Length of the record, without the header.
+ */
+void EncodeRecordHeader( MultiLibrary::OutputStream &stream, RecordKind kind, uint32_t length );
+
+/*!
+ \brief Write a record header.
+
+ \param stream Writer to write to.
+ \param kind Kind of the record.
+ \param length Length of the record, without the header.
+
+ \overload
+ */
+void EncodeRecordHeader( BufferWriter &stream, RecordKind kind, uint32_t length );
+
+/*!
+ \brief Read a record header.
+
+ \param stream Stream to read from.
+ \param header Where to store the header.
+
+ \return false if the header is truncated, true otherwise.
+ */
+bool DecodeRecordHeader( MultiLibrary::InputStream &stream, RecordHeader &header );
+
+/*!
+ \brief Read a record header.
+
+ \param view View to read from.
+ \param header Where to store the header.
+
+ \return false if the header is truncated, true otherwise.
+
+ \overload
+ */
+bool DecodeRecordHeader( BufferView &view, RecordHeader &header );
+
+/*!
+ \brief Skip the remainder of a record.
+
+ \param stream Stream to read from, positioned after the record header.
+ \param header Header of the record to skip.
+
+ \return false if the record is truncated, true otherwise.
+ */
+bool SkipRecord( MultiLibrary::InputStream &stream, const RecordHeader &header );
+
+/*!
+ \brief Skip the body of a record.
+
+ \param view View to read from, positioned after the record header.
+ \param header Header of the record.
+
+ \return false if the record is truncated, true otherwise.
+
+ \overload
+ */
+bool SkipRecord( BufferView &view, const RecordHeader &header );
+
+/*!
+ \brief Write a spew record, including its header.
+
+ \param stream Stream to write to.
+ \param state State of the frame being written, updated with this record.
+ \param type Spew type.
+ \param level Spew level.
+ \param group Spew group identifier.
+ \param color Raw spew color.
+ \param sequence Sequence number.
+ \param time Monotonic capture time, in nanoseconds.
+ \param message Message text.
+ \param message_length Length of the message, without terminator.
+ */
+void EncodeSpewRecord(
+	MultiLibrary::OutputStream &stream,
+	SpewState &state,
+	int32_t type,
+	int32_t level,
+	uint32_t group,
+	int32_t color,
+	uint64_t sequence,
+	uint64_t time,
+	const char *message,
+	size_t message_length
+);
+
+/*!
+ \brief Write a spew record, including its header.
+
+ This is the one frames are built with, it has no virtual calls.
+
+ \param stream Writer to write to.
+ \param state State of the frame being written, updated with this record.
+ \param type Spew type.
+ \param level Spew level.
+ \param group Spew group identifier.
+ \param color Raw spew color.
+ \param sequence Sequence number.
+ \param time Monotonic capture time, in nanoseconds.
+ \param message Message text.
+ \param message_length Length of the message, without terminator.
+
+ \overload
+ */
+void EncodeSpewRecord(
+	BufferWriter &stream,
+	SpewState &state,
+	int32_t type,
+	int32_t level,
+	uint32_t group,
+	int32_t color,
+	uint64_t sequence,
+	uint64_t time,
+	const char *message,
+	size_t message_length
+);
+
+/*!
+ \brief Read the body of a spew record.
+
+ \param stream Stream to read from, positioned after the record header.
+ \param header Header of the record.
+ \param state State of the frame being read, updated with this record.
+ \param record Where to store the record.
+
+ \return false if the record is truncated or malformed, true otherwise.
+ */
+bool DecodeSpewRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	SpewState &state,
+	SpewRecord &record
+);
+
+/*!
+ \brief Read the body of a spew record, without copying the message.
+
+ \param view View to read from, positioned after the record header.
+ \param header Header of the record.
+ \param state State of the frame being read, updated with this record.
+ \param record Where to store the record.
+
+ \return false if the record is truncated or malformed, true otherwise.
+
+ \overload
+ */
+bool DecodeSpewRecord(
+	BufferView &view,
+	const RecordHeader &header,
+	SpewState &state,
+	SpewRecordView &record
+);
+
+/*!
+ \brief Write a group record, including its header.
+
+ \param stream Stream to write to.
+ \param group Group identifier.
+ \param name Group name.
+ \param length Length of the group name, without terminator.
+ */
+void EncodeGroupRecord(
+	MultiLibrary::OutputStream &stream,
+	uint32_t group,
+	const char *name,
+	size_t length
+);
+
+/*!
+ \brief Read the body of a group record.
+
+ \param stream Stream to read from, positioned after the record header.
+ \param header Header of the record.
+ \param group Where to store the group identifier.
+ \param name Where to store the group name.
+
+ \return false if the record is truncated or malformed, true otherwise.
+ */
+bool DecodeGroupRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	uint32_t &group,
+	std::string &name
+);
+
+/*!
+ \brief Read the body of a group record, without copying the name.
+
+ \param view View to read from, positioned after the record header.
+ \param header Header of the record.
+ \param group Where to store the group identifier.
+ \param name Where to store the group name.
+
+ \return false if the record is truncated or malformed, true otherwise.
+
+ \overload
+ */
+bool DecodeGroupRecord(
+	BufferView &view,
+	const RecordHeader &header,
+	uint32_t &group,
+	StringView &name
+);
+
+/*!
+ \brief Write a hello record, including its header.
+
+ \param stream Stream to write to.
+ \param record Record to write.
+ */
+void EncodeHelloRecord( MultiLibrary::OutputStream &stream, const HelloRecord &record );
+
+/*!
+ \brief Read the body of a hello record.
+
+ \param stream Stream to read from, positioned after the record header.
+ \param header Header of the record.
+ \param record Where to store the record.
+
+ \return false if the record is truncated or malformed, true otherwise.
+ */
+bool DecodeHelloRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	HelloRecord &record
+);
+
+/*!
+ \brief Write a gap record, including its header.
+
+ \param stream Stream to write to.
+ \param records Amount of records that were lost.
+ */
+void EncodeGapRecord( MultiLibrary::OutputStream &stream, uint64_t records );
+
+/*!
+ \brief Write a gap record, including its header.
+
+ \param stream Writer to write to.
+ \param records Amount of records that were lost.
+
+ \overload
+ */
+void EncodeGapRecord( BufferWriter &stream, uint64_t records );
+
+/*!
+ \brief Read the body of a gap record.
+
+ \param stream Stream to read from, positioned after the record header.
+ \param header Header of the record.
+ \param records Where to store the amount of records that were lost.
+
+ \return false if the record is truncated or malformed, true otherwise.
+ */
+bool DecodeGapRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	uint64_t &records
+);
+
+/*!
+ \brief Read the body of a gap record.
+
+ \param view View to read from, positioned after the record header.
+ \param header Header of the record.
+ \param records Where to store the amount of records that were lost.
+
+ \return false if the record is truncated or malformed, true otherwise.
+
+ \overload
+ */
+bool DecodeGapRecord(
+	BufferView &view,
+	const RecordHeader &header,
+	uint64_t &records
+);
+
+/*!
+ \brief Write a subscribe record, including its header.
+
+ \param stream Stream to write to.
+ \param record Record to write.
+ */
+void EncodeSubscribeRecord( MultiLibrary::OutputStream &stream, const SubscribeRecord &record );
+
+/*!
+ \brief Read the body of a subscribe record.
+
+ \param stream Stream to read from, positioned after the record header.
+ \param header Header of the record.
+ \param record Where to store the record.
+
+ \return false if the record is truncated or malformed, true otherwise.
+ */
+bool DecodeSubscribeRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	SubscribeRecord &record
+);
+
+/*!
+ \brief Write a stats record, including its header.
+
+ \param stream Stream to write to.
+ \param record Record to write.
+ */
+void EncodeStatsRecord( MultiLibrary::OutputStream &stream, const StatsRecord &record );
+
+/*!
+ \brief Read the body of a stats record.
+
+ \param stream Stream to read from, positioned after the record header.
+ \param header Header of the record.
+ \param record Where to store the record.
+
+ \return false if the record is truncated or malformed, true otherwise.
+ */
+bool DecodeStatsRecord(
+	MultiLibrary::InputStream &stream,
+	const RecordHeader &header,
+	StatsRecord &record
+);
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <BufferView.hpp>
+#include <InputStream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace xconsole
+{
+
+/*
+ Fixed layouts of records, declared once and used for both encoding and
+ decoding, so the two can't drift apart. A record declares its fields in
+ order by specializing SchemaOf:
+
+ template<>
+ struct SchemaOf<RecordHeader>
+ {
+ 	typedef Schema<
+ 		Field<RecordHeader, uint8_t, &RecordHeader::kind>,
+ 		Field<RecordHeader, uint32_t, &RecordHeader::length>
+ 	> Type;
+ };
+
+ The size of the layout is known at compile time, so encoding is a single
+ bounds checked write of a block whose fields are plain stores, and
+ decoding is a single bounds checked read. Values have the same layout as
+ the stream operators, without padding.
+ */
+
+/*!
+ \brief A field of a record, stored at full width.
+ */
+template<typename Record, typename Value, Value Record::*member>
+struct Field
+{
+	static_assert( std::is_arithmetic<Value>::value, "fields must be arithmetic values" );
+
+	static const size_t size = sizeof( Value );
+
+	static void Store( uint8_t *data, const Record &record )
+	{
+		std::memcpy( data, &( record.*member ), sizeof( Value ) );
+	}
+
+	static void Load( const uint8_t *data, Record &record )
+	{
+		std::memcpy( &( record.*member ), data, sizeof( Value ) );
+	}
+};
+
+/*!
+ \brief An ordered list of fields.
+ */
+template<typename... Fields>
+struct Schema;
+
+template<>
+struct Schema<>
+{
+	static const size_t size = 0;
+
+	template<typename Record>
+	static void Store( uint8_t *, const Record & )
+	{ }
+
+	template<typename Record>
+	static void Load( const uint8_t *, Record & )
+	{ }
+};
+
+template<typename First, typename... Rest>
+struct Schema<First, Rest...>
+{
+	static const size_t size = First::size + Schema<Rest...>::size;
+
+	template<typename Record>
+	static void Store( uint8_t *data, const Record &record )
+	{
+		First::Store( data, record );
+		Schema<Rest...>::Store( data + First::size, record );
+	}
+
+	template<typename Record>
+	static void Load( const uint8_t *data, Record &record )
+	{
+		First::Load( data, record );
+		Schema<Rest...>::Load( data + First::size, record );
+	}
+};
+
+/*!
+ \brief Schema of a record, specialized for every record that has one.
+ */
+template<typename Record>
+struct SchemaOf;
+
+/*!
+ \brief Return the encoded size of a record.
+
+ \return Size of the record, in bytes.
+ */
+template<typename Record>
+inline size_t FieldsSize( )
+{
+	return SchemaOf<Record>::Type::size;
+}
+
+/*!
+ \brief Encode the fields of a record into memory.
+
+ \param data Where to write, with room for FieldsSize bytes.
+ \param record Record to encode.
+ */
+template<typename Record>
+inline void StoreFields( uint8_t *data, const Record &record )
+{
+	SchemaOf<Record>::Type::Store( data, record );
+}
+
+/*!
+ \brief Write the fields of a record to a stream or writer, as one block.
+
+ \param stream Anything with a Write( data, size ) method.
+ \param record Record to write.
+ */
+template<typename Stream, typename Record>
+inline void EncodeFields( Stream &stream, const Record &record )
+{
+	typedef typename SchemaOf<Record>::Type Type;
+
+	uint8_t data[Type::size];
+	Type::Store( data, record );
+	stream.Write( data, Type::size );
+}
+
+/*!
+ \brief Decode the fields of a record from memory.
+
+ \param data Memory to read from, holding at least FieldsSize bytes.
+ \param record Where to store the record.
+ */
+template<typename Record>
+inline void LoadFields( const uint8_t *data, Record &record )
+{
+	SchemaOf<Record>::Type::Load( data, record );
+}
+
+/*!
+ \brief Read the fields of a record from a view.
+
+ \param view View to read from.
+ \param record Where to store the record, left untouched on failure.
+
+ \return false if the record is truncated, true otherwise.
+ */
+template<typename Record>
+inline bool DecodeFields( BufferView &view, Record &record )
+{
+	typedef typename SchemaOf<Record>::Type Type;
+
+	const uint8_t *data = nullptr;
+	if( !view.ReadBytes( Type::size, data ) )
+		return false;
+
+	Type::Load( data, record );
+	return true;
+}
+
+/*!
+ \brief Read the fields of a record from a stream.
+
+ \param stream Stream to read from.
+ \param record Where to store the record, left untouched on failure.
+
+ \return false if the record is truncated, true otherwise.
+
+ \overload
+ */
+template<typename Record>
+inline bool DecodeFields( MultiLibrary::InputStream &stream, Record &record )
+{
+	typedef typename SchemaOf<Record>::Type Type;
+
+	uint8_t data[Type::size];
+	if( stream.Read( data, Type::size ) != Type::size )
+		return false;
+
+	Type::Load( data, record );
+	return true;
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,369 @@
+/*************************************************************************
+ * MultiLibrary - danielga.bitbucket.org/multilibrary
+ * A C++ library that covers multiple low level systems.
+ *------------------------------------------------------------------------
+ * Copyright (c) 2015, Daniel Almeida
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************/
+
+#include <SegmentedBuffer.hpp>
+#include <cassert>
+#include <cstring>
+
+namespace MultiLibrary
+{
+
+ChunkPool::ChunkPool( size_t chunk_size, size_t max_free ) :
+	chunk_size( chunk_size ),
+	max_free( max_free )
+{
+	assert( chunk_size != 0 );
+}
+
+ChunkPool::~ChunkPool( )
+{
+	for( uint8_t *chunk : free_chunks )
+		delete[] chunk;
+}
+
+size_t ChunkPool::GetChunkSize( ) const
+{
+	return chunk_size;
+}
+
+size_t ChunkPool::GetFreeChunks( ) const
+{
+	std::lock_guard<std::mutex> lock( pool_mutex );
+	return free_chunks.size( );
+}
+
+uint8_t *ChunkPool::Acquire( )
+{
+	{
+		std::lock_guard<std::mutex> lock( pool_mutex );
+		if( !free_chunks.empty( ) )
+		{
+			uint8_t *chunk = free_chunks.back( );
+			free_chunks.pop_back( );
+			return chunk;
+		}
+	}
+
+	return new uint8_t[chunk_size];
+}
+
+void ChunkPool::Release( uint8_t *chunk )
+{
+	{
+		std::lock_guard<std::mutex> lock( pool_mutex );
+		if( free_chunks.size( ) < max_free )
+		{
+			free_chunks.push_back( chunk );
+			return;
+		}
+	}
+
+	delete[] chunk;
+}
+
+SegmentedBuffer::SegmentedBuffer( ChunkPool &pool ) :
+	chunk_pool( pool ),
+	chunk_size( pool.GetChunkSize( ) ),
+	chunk_offset( 0 ),
+	buffer_size( 0 ),
+	buffer_offset( 0 ),
+	end_of_file( true )
+{ }
+
+SegmentedBuffer::~SegmentedBuffer( )
+{
+	for( uint8_t *chunk : chunks )
+		chunk_pool.Release( chunk );
+}
+
+bool SegmentedBuffer::IsValid( ) const
+{
+	return !EndOfFile( );
+}
+
+SegmentedBuffer::operator bool( ) const
+{
+	return IsValid( );
+}
+
+bool SegmentedBuffer::operator!( ) const
+{
+	return !IsValid( );
+}
+
+int64_t SegmentedBuffer::Tell( ) const
+{
+	return static_cast<int64_t>( buffer_offset );
+}
+
+int64_t SegmentedBuffer::Size( ) const
+{
+	return static_cast<int64_t>( buffer_size );
+}
+
+size_t SegmentedBuffer::Capacity( ) const
+{
+	return chunks.size( ) * chunk_size - chunk_offset;
+}
+
+bool SegmentedBuffer::Seek( int64_t position, SeekMode mode )
+{
+	assert( mode != SEEKMODE_SET || ( mode == SEEKMODE_SET && position >= 0 ) );
+	assert( mode != SEEKMODE_CUR || ( mode == SEEKMODE_CUR && Tell( ) + position >= 0 ) );
+	assert( mode != SEEKMODE_END || ( mode == SEEKMODE_END && Size( ) + position >= 0 ) );
+
+	int64_t temp;
+	switch( mode )
+	{
+	case SEEKMODE_SET:
+		buffer_offset = static_cast<size_t>( position > 0 ? position : 0 );
+		break;
+
+	case SEEKMODE_CUR:
+		temp = Tell( ) + position;
+		buffer_offset = static_cast<size_t>( temp > 0 ? temp : 0 );
+		break;
+
+	case SEEKMODE_END:
+		temp = Size( ) + position;
+		buffer_offset = static_cast<size_t>( temp > 0 ? temp : 0 );
+		break;
+
+	default:
+		return false;
+	}
+
+	end_of_file = false;
+	return true;
+}
+
+bool SegmentedBuffer::EndOfFile( ) const
+{
+	return end_of_file;
+}
+
+ChunkPool &SegmentedBuffer::GetPool( ) const
+{
+	return chunk_pool;
+}
+
+void SegmentedBuffer::Clear( )
+{
+	for( uint8_t *chunk : chunks )
+		chunk_pool.Release( chunk );
+
+	chunks.clear( );
+	chunk_offset = 0;
+	buffer_size = 0;
+	buffer_offset = 0;
+	end_of_file = false;
+}
+
+void SegmentedBuffer::Reserve( size_t capacity )
+{
+	while( Capacity( ) < capacity )
+		chunks.push_back( chunk_pool.Acquire( ) );
+}
+
+void SegmentedBuffer::Trim( size_t size )
+{
+	if( size > buffer_size )
+		size = buffer_size;
+
+	buffer_size -= size;
+	buffer_offset = buffer_offset > size ? buffer_offset - size : 0;
+
+	// the chunks past the data are kept, only the ones left behind are released
+	chunk_offset += size;
+	while( !chunks.empty( ) && chunk_offset >= chunk_size )
+	{
+		chunk_pool.Release( chunks.front( ) );
+		chunks.pop_front( );
+		chunk_offset -= chunk_size;
+	}
+
+	if( chunks.empty( ) )
+		chunk_offset = 0;
+}
+
+size_t SegmentedBuffer::GetVectors( IoVector *vectors, size_t count, size_t offset ) const
+{
+	assert( vectors != nullptr || count == 0 );
+
+	size_t stored = 0;
+	while( stored < count && offset < buffer_size )
+	{
+		size_t available = 0;
+		const uint8_t *data = Locate( offset, available );
+		if( available > buffer_size - offset )
+			available = buffer_size - offset;
+
+		vectors[stored].data = data;
+		vectors[stored].size = available;
+		offset += available;
+		++stored;
+	}
+
+	return stored;
+}
+
+size_t SegmentedBuffer::Read( void *value, size_t size )
+{
+	assert( value != nullptr && size != 0 );
+
+	if( buffer_offset >= buffer_size )
+	{
+		end_of_file = true;
+		return 0;
+	}
+
+	size_t clamped = buffer_size - buffer_offset;
+	if( clamped > size )
+		clamped = size;
+
+	uint8_t *bytes = static_cast<uint8_t *>( value );
+	for( size_t left = clamped; left != 0; )
+	{
+		size_t available = 0;
+		const uint8_t *data = Locate( buffer_offset, available );
+		if( available > left )
+			available = left;
+
+		std::memcpy( bytes, data, available );
+		bytes += available;
+		buffer_offset += available;
+		left -= available;
+	}
+
+	if( clamped < size )
+		end_of_file = true;
+
+	return clamped;
+}
+
+const uint8_t *SegmentedBuffer::Peek( size_t &size ) const
+{
+	if( buffer_offset >= buffer_size )
+	{
+		size = 0;
+		return nullptr;
+	}
+
+	const uint8_t *data = Locate( buffer_offset, size );
+	if( size > buffer_size - buffer_offset )
+		size = buffer_size - buffer_offset;
+
+	return data;
+}
+
+size_t SegmentedBuffer::Write( const void *value, size_t size )
+{
+	assert( value != nullptr && size != 0 );
+
+	Reserve( buffer_offset + size );
+
+	const uint8_t *bytes = static_cast<const uint8_t *>( value );
+	for( size_t left = size; left != 0; )
+	{
+		size_t available = 0;
+		uint8_t *data = Locate( buffer_offset, available );
+		if( available > left )
+			available = left;
+
+		std::memcpy( data, bytes, available );
+		bytes += available;
+		buffer_offset += available;
+		left -= available;
+	}
+
+	if( buffer_size < buffer_offset )
+		buffer_size = buffer_offset;
+
+	return size;
+}
+
+size_t SegmentedBuffer::WriteV( const IoVector *vectors, size_t count )
+{
+	assert( vectors != nullptr || count == 0 );
+
+	size_t size = 0;
+	for( size_t k = 0; k < count; ++k )
+		size += vectors[k].size;
+
+	if( size == 0 )
+		return 0;
+
+	Reserve( buffer_offset + size );
+	for( size_t k = 0; k < count; ++k )
+		if( vectors[k].size != 0 )
+			Write( vectors[k].data, vectors[k].size );
+
+	return size;
+}
+
+uint8_t *SegmentedBuffer::Prepare( size_t &size )
+{
+	assert( size != 0 );
+
+	Reserve( buffer_offset + 1 );
+
+	size_t available = 0;
+	uint8_t *data = Locate( buffer_offset, available );
+	if( size > available )
+		size = available;
+
+	return data;
+}
+
+void SegmentedBuffer::Commit( size_t size )
+{
+	assert( buffer_offset + size <= Capacity( ) );
+
+	buffer_offset += size;
+	if( buffer_size < buffer_offset )
+		buffer_size = buffer_offset;
+}
+
+uint8_t *SegmentedBuffer::Locate( size_t position, size_t &available ) const
+{
+	assert( position < Capacity( ) );
+
+	const size_t offset = chunk_offset + position;
+	available = chunk_size - offset % chunk_size;
+	return chunks[offset / chunk_size] + offset % chunk_size;
+}
+
+} // namespace MultiLibrary
\ No newline at end of file
@@ -0,0 +1,339 @@
+/*************************************************************************
+ * MultiLibrary - danielga.bitbucket.org/multilibrary
+ * A C++ library that covers multiple low level systems.
+ *------------------------------------------------------------------------
+ * Copyright (c) 2015, Daniel Almeida
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ *************************************************************************/
+
+#pragma once
+
+#include <IOStream.hpp>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+namespace MultiLibrary
+{
+
+/*!
+ \brief A pool of fixed size blocks of memory for segmented buffers.
+
+ Released chunks are kept for reuse, up to a limit, so buffers that keep
+ growing and shrinking don't go back to the allocator every time. Can be
+ shared between threads and must outlive every buffer using it.
+ */
+class ChunkPool
+{
+public:
+	/*!
+	 \brief Create a pool of chunks of the provided size.
+
+	 \param chunk_size Size of every chunk.
+	 \param max_free (Optional) Amount of released chunks kept for reuse.
+	 */
+	ChunkPool( size_t chunk_size = 4096, size_t max_free = 256 );
+
+	/*!
+	 \brief Destructor.
+
+	 Frees the chunks kept for reuse.
+	 */
+	~ChunkPool( );
+
+	/*!
+	 \brief Return the size of every chunk.
+
+	 \return Size of the chunks.
+	 */
+	size_t GetChunkSize( ) const;
+
+	/*!
+	 \brief Return the amount of chunks kept for reuse.
+
+	 \return Amount of free chunks.
+	 */
+	size_t GetFreeChunks( ) const;
+
+	/*!
+	 \brief Take a chunk, reusing a released one if possible.
+
+	 \return Uninitialized chunk of GetChunkSize bytes.
+	 */
+	uint8_t *Acquire( );
+
+	/*!
+	 \brief Give back a chunk taken from this pool.
+
+	 \param chunk Chunk to give back.
+	 */
+	void Release( uint8_t *chunk );
+
+private:
+	ChunkPool( const ChunkPool & );
+	ChunkPool &operator=( const ChunkPool & );
+
+	mutable std::mutex pool_mutex;
+	std::vector<uint8_t *> free_chunks;
+	size_t chunk_size;
+	size_t max_free;
+};
+
+/*!
+ \brief A buffer made of a chain of fixed size chunks.
+
+ Works like ByteBuffer, but growing only adds chunks at the end, so the
+ data is never moved and large buffers don't need large allocations.
+ Data can also be dropped from the start (like a queue) and the chunks
+ can be handed to vectored writes as they are. The price is that the data
+ is only contiguous within each chunk.
+ */
+class SegmentedBuffer : public IOStream
+{
+public:
+	/*!
+	 \brief Create an empty buffer that takes its chunks from the provided pool.
+
+	 \param pool Pool of chunks, which must outlive the buffer.
+	 */
+	SegmentedBuffer( ChunkPool &pool );
+
+	/*!
+	 \brief Destructor.
+
+	 Gives every chunk back to the pool.
+	 */
+	~SegmentedBuffer( );
+
+	/*!
+	 \brief Tell if the buffer is valid.
+
+	 Currently just checks if we reached the end of the buffer.
+
+	 \return If we haven't reached the end of the buffer, true, otherwise false.
+
+	 \sa EndOfFile
+	 */
+	bool IsValid( ) const;
+
+	/*!
+	 \brief Tell if the object is valid.
+
+	 Currently just returns the value of IsValid.
+
+	 \return A boolean type relative to IsValid.
+
+	 \sa IsValid
+	 */
+	explicit operator bool( ) const;
+
+	/*!
+	 \brief Tell if the object is not valid.
+
+	 Currently just returns the reverse of IsValid.
+
+	 \return Validness of this object.
+
+	 \sa IsValid
+	 */
+	bool operator!( ) const;
+
+	/*!
+	 \brief Return the current position on the buffer.
+
+	 \return Current position of read/write operations on the buffer.
+	 */
+	int64_t Tell( ) const;
+
+	/*!
+	 \brief Return the size of the buffer.
+
+	 \return Size of the buffer.
+
+	 \sa Capacity
+	 */
+	int64_t Size( ) const;
+
+	/*!
+	 \brief Return the amount of bytes the current chunks can hold.
+
+	 \return Capacity of this object.
+
+	 \sa Size
+	 */
+	size_t Capacity( ) const;
+
+	/*!
+	 \brief Set the current position of read/write operations.
+
+	 Currently this operation is always successful.
+
+	 \param position Position to set the pointer to.
+	 \param mode (Optional) Type of seeking pretended.
+
+	 \return Success of this operation.
+	 */
+	bool Seek( int64_t position, SeekMode mode = SEEKMODE_SET );
+
+	/*!
+	 \brief Tell if the end of file was reached.
+
+	 In this case, end of file means we reached the end of the buffer.
+
+	 \return End of buffer reached.
+	 */
+	bool EndOfFile( ) const;
+
+	/*!
+	 \brief Return the pool the chunks are taken from.
+
+	 \return Pool of chunks.
+	 */
+	ChunkPool &GetPool( ) const;
+
+	/*!
+	 \brief Reset the buffer.
+
+	 All data is wiped, all flags reset and every chunk given back to the
+	 pool.
+	 */
+	void Clear( );
+
+	/*!
+	 \brief Add chunks until the buffer can hold the provided amount of bytes.
+
+	 \param capacity New capacity of the buffer.
+	 */
+	void Reserve( size_t capacity );
+
+	/*!
+	 \brief Drop data from the start of the buffer.
+
+	 Chunks left empty are given back to the pool, nothing is moved. The
+	 position moves back by the same amount, stopping at the start.
+
+	 \param size Amount of bytes to drop, clamped to the size of the buffer.
+	 */
+	void Trim( size_t size );
+
+	/*!
+	 \brief Describe the data of the buffer as pieces of memory, one per chunk.
+
+	 The pieces can be passed straight to a vectored write and stay valid
+	 until the buffer is changed.
+
+	 \param vectors Where to store the pieces.
+	 \param count Maximum amount of pieces to store.
+	 \param offset (Optional) Where in the buffer to start from.
+
+	 \return Amount of pieces stored.
+	 */
+	size_t GetVectors( IoVector *vectors, size_t count, size_t offset = 0 ) const;
+
+	/*!
+	 \brief Read data from the buffer.
+
+	 \param value Pointer to the buffer to write to.
+	 \param size Amount to read.
+
+	 \return Size in bytes of the read data.
+	 */
+	size_t Read( void *value, size_t size );
+
+	/*!
+	 \brief Return the unread data of the current chunk.
+
+	 \param size Where to store the amount of bytes returned.
+
+	 \return Pointer to the unread data.
+	 */
+	const uint8_t *Peek( size_t &size ) const;
+
+	/*!
+	 \brief Write data to the buffer.
+
+	 \param value Pointer to the data to write.
+	 \param size Size of the provided data.
+
+	 \return Size in bytes of the written data.
+	 */
+	size_t Write( const void *value, size_t size );
+
+	/*!
+	 \brief Write several pieces of data to the buffer, growing it once.
+
+	 \param vectors Pieces to write.
+	 \param count Amount of pieces.
+
+	 \return Size in bytes of the written data.
+	 */
+	size_t WriteV( const IoVector *vectors, size_t count );
+
+	/*!
+	 \brief Make room to write in place at the current position.
+
+	 Works like ByteBuffer::Prepare, but the room ends with the chunk, so
+	 less than asked for can be returned.
+
+	 \param size Amount of bytes to make room for, replaced with the amount
+	 returned.
+
+	 \return Pointer to size writable bytes.
+
+	 \sa Commit
+	 */
+	uint8_t *Prepare( size_t &size );
+
+	/*!
+	 \brief Keep bytes written to the memory returned by Prepare.
+
+	 \param size Amount of bytes written, up to the prepared amount.
+
+	 \sa Prepare
+	 */
+	void Commit( size_t size );
+
+private:
+	SegmentedBuffer( const SegmentedBuffer & );
+	SegmentedBuffer &operator=( const SegmentedBuffer & );
+
+	uint8_t *Locate( size_t position, size_t &available ) const;
+
+	ChunkPool &chunk_pool;
+	size_t chunk_size;
+	std::deque<uint8_t *> chunks;
+	size_t chunk_offset;
+	size_t buffer_size;
+	size_t buffer_offset;
+	bool end_of_file;
+};
+
+} // namespace MultiLibrary
\ No newline at end of file
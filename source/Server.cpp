@@ -0,0 +1,844 @@
+#include <Server.hpp>
+#include <MemoryBuffer.hpp>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace xconsole
+{
+
+static const size_t queue_size = 4 * 1024 * 1024;
+
+// queued spew, followed by the message
+struct CaptureRecord
+{
+	int32_t type;
+	int32_t level;
+	uint32_t group;
+	int32_t color;
+	uint64_t sequence;
+	uint64_t ticks;
+};
+
+template<>
+struct SchemaOf<CaptureRecord>
+{
+	typedef Schema<
+		Field<CaptureRecord, int32_t, &CaptureRecord::type>,
+		Field<CaptureRecord, int32_t, &CaptureRecord::level>,
+		Field<CaptureRecord, uint32_t, &CaptureRecord::group>,
+		Field<CaptureRecord, int32_t, &CaptureRecord::color>,
+		Field<CaptureRecord, uint64_t, &CaptureRecord::sequence>,
+		Field<CaptureRecord, uint64_t, &CaptureRecord::ticks>
+	> Type;
+};
+
+static const size_t capture_header_size = SchemaOf<CaptureRecord>::Type::size;
+static const size_t max_spew_record_size =
+	record_header_size + 1 + sizeof( int32_t ) * 4 + sizeof( uint64_t ) * 2;
+
+// smaller frames rarely shrink enough to be worth it
+static const size_t min_compress_size = 256;
+
+static const int stats_interval = 100;
+
+static ClientPolicy LimitPolicy( const HelloRecord &hello, const ClientPolicy &limits )
+{
+	// consoles can only ask for less than what the server allows: blocking
+	// holds every other console up, so only a blocking server lets them block
+	ClientPolicy policy = limits;
+	if( hello.policy != POLICY_BLOCK || limits.policy == POLICY_BLOCK )
+		policy.policy = static_cast<BackpressurePolicy>( hello.policy );
+
+	if( hello.budget != 0 && hello.budget < limits.budget )
+		policy.budget = hello.budget;
+
+	// a parameter of 0 keeps the server's value, like the budget, and
+	// sampling can only keep fewer frames than the server would
+	if( policy.policy == POLICY_BLOCK && hello.parameter != 0 &&
+		hello.parameter < static_cast<uint32_t>( limits.block_timeout ) )
+		policy.block_timeout = static_cast<int>( hello.parameter );
+	else if( policy.policy == POLICY_SAMPLE && hello.parameter > limits.sample_rate )
+		policy.sample_rate = hello.parameter;
+
+	return policy;
+}
+
+ServerOptions::ServerOptions( ) :
+	batch_bytes( 16 * 1024 ),
+	batch_records( 256 ),
+	flush_interval( 1 ),
+	low_latency( true ),
+	compression( true ),
+	shared_size( 8 * 1024 * 1024 ),
+	history_size( 4 * 1024 * 1024 )
+{ }
+
+Server::Server( ) :
+	queue( queue_size ),
+	capture_sequence( 0 ),
+	writer_sleeping( false ),
+	client_count( 0 ),
+	channels_changed( false ),
+	reported_drops( 0 ),
+	batch_groups( 0 ),
+	flush_ticks( 0 ),
+	stats_dirty( false ),
+	interest_all( true ),
+	interest_types( 0 ),
+	interest_level( INT32_MAX ),
+	interest_group_count( 0 )
+{
+	for( std::atomic<uint64_t> &bits : interest_groups )
+		bits.store( 0, std::memory_order_relaxed );
+
+	for( uint64_t &counter : stats_counters )
+		counter = 0;
+
+	published_stats.counters.assign( STATS_COUNTER_COUNT, 0 );
+}
+
+Server::~Server( )
+{
+	Stop( );
+}
+
+bool Server::Start( const std::string &path, const ServerOptions &options )
+{
+	server_options = options;
+	clock.Reset( );
+	channels.emplace_back( new Channel( nullptr, options.batch_bytes ) );
+	history.SetLimit( options.history_size );
+
+	if( !options.shared_name.empty( ) && !shared_ring.Open( options.shared_name, options.shared_size ) )
+		return false;
+
+	transport.reset( Transport::Create( ) );
+	if( !transport || !transport->Open( path, this ) )
+	{
+		transport.reset( );
+		shared_ring.Close( );
+		channels.clear( );
+		return false;
+	}
+
+	UpdateInterest( );
+	writer_thread = std::thread( &Server::WriterThread, this );
+	return true;
+}
+
+void Server::Stop( )
+{
+	if( !transport )
+		return;
+
+	transport->Shutdown( );
+	writer_thread.join( );
+
+	batch_groups = 0;
+	history.Clear( );
+	clients.clear( );
+	client_count = 0;
+	channels.clear( );
+	channels_changed = false;
+	interest_all = true;
+
+	transport->Close( );
+	transport.reset( );
+	shared_ring.Close( );
+}
+
+bool Server::WantsRecords( ) const
+{
+	return server_options.history_size != 0 ||
+		client_count.load( std::memory_order_relaxed ) != 0 || shared_ring.HasReaders( );
+}
+
+bool Server::Capture(
+	int32_t type,
+	int32_t level,
+	const char *group,
+	int32_t color,
+	const char *message
+)
+{
+	const uint64_t ticks = Clock::Ticks( );
+	const uint32_t group_id = groups.Intern( group, std::strlen( group ) );
+	if( !IsWanted( type, level, group_id ) )
+		return true;
+
+	// numbered even if dropped, so consoles can tell from the holes
+	const uint64_t sequence = capture_sequence.fetch_add( 1, std::memory_order_relaxed );
+
+	const size_t message_length = std::strlen( message );
+	const size_t size = capture_header_size + message_length;
+
+	// the record is encoded straight into the queue, nothing is allocated
+	uint8_t *record = queue.Reserve( size );
+	if( record == nullptr )
+		return false;
+
+	CaptureRecord capture;
+	capture.type = type;
+	capture.level = level;
+	capture.group = group_id;
+	capture.color = color;
+	capture.sequence = sequence;
+	capture.ticks = ticks;
+	StoreFields( record, capture );
+	if( message_length != 0 )
+		std::memcpy( record + capture_header_size, message, message_length );
+
+	queue.Commit( record, size );
+	WakeWriter( );
+	enqueue_latency.Add( Clock::Ticks( ) - ticks );
+	return true;
+}
+
+void Server::GetStats( StatsRecord &stats ) const
+{
+	std::lock_guard<std::mutex> lock( stats_mutex );
+	stats = published_stats;
+}
+
+bool Server::IsWanted( int32_t type, int32_t level, uint32_t group ) const
+{
+	// patterns are only checked by the writer, this just rules out what no
+	// subscription can match
+	if( interest_all.load( std::memory_order_acquire ) || shared_ring.HasReaders( ) )
+		return true;
+
+	if( type < 0 || type >= 32 ||
+		( interest_types.load( std::memory_order_relaxed ) & ( 1u << type ) ) == 0 ||
+		level < interest_level.load( std::memory_order_relaxed ) )
+		return false;
+
+	// groups newer than the summary are let through until it's rebuilt
+	if( group >= interest_group_count.load( std::memory_order_relaxed ) )
+		return true;
+
+	return ( interest_groups[group / 64].load( std::memory_order_relaxed ) >> ( group % 64 ) & 1 ) != 0;
+}
+
+void Server::WakeWriter( )
+{
+	// pairs with the fence in WriterThread, either we see it sleeping or it
+	// sees our record before going to sleep
+	std::atomic_thread_fence( std::memory_order_seq_cst );
+	if( writer_sleeping.load( std::memory_order_relaxed ) &&
+		writer_sleeping.exchange( false, std::memory_order_relaxed ) )
+		transport->Wake( );
+}
+
+void Server::WriterThread( )
+{
+	while( true )
+	{
+		writer_sleeping.store( false, std::memory_order_relaxed );
+		clock.Calibrate( );
+		stats_dirty = true;
+
+		// channels are only removed here, never while they're being flushed
+		if( channels_changed )
+		{
+			channels_changed = false;
+			channels.erase(
+				std::remove_if(
+					channels.begin( ) + 1,
+					channels.end( ),
+					[]( const std::unique_ptr<Channel> &channel )
+					{
+						return channel->GetSubscribers( ) == 0;
+					}
+				),
+				channels.end( )
+			);
+			UpdateInterest( );
+		}
+
+		size_t size = 0;
+		const uint8_t *record = nullptr;
+		while( ( record = queue.Peek( size ) ) != nullptr )
+		{
+			Append( record, size );
+			queue.Pop( );
+		}
+
+		// every channel is flushed at once, when the oldest frame is due
+		int timeout = -1;
+		const Channel *oldest = nullptr;
+		for( const std::unique_ptr<Channel> &channel : channels )
+			if( !channel->IsEmpty( ) && ( oldest == nullptr || channel->GetStart( ) < oldest->GetStart( ) ) )
+				oldest = channel.get( );
+
+		if( oldest != nullptr )
+		{
+			const int elapsed = static_cast<int>(
+				std::chrono::duration_cast<std::chrono::milliseconds>(
+					std::chrono::steady_clock::now( ) - oldest->GetStart( )
+				).count( )
+			);
+			if( server_options.low_latency || elapsed >= server_options.flush_interval )
+				Flush( );
+			else
+				timeout = server_options.flush_interval - elapsed;
+		}
+
+		// published at a limited rate, and only once things change
+		if( stats_dirty )
+		{
+			const auto now = std::chrono::steady_clock::now( );
+			const int elapsed = static_cast<int>(
+				std::chrono::duration_cast<std::chrono::milliseconds>( now - stats_time ).count( )
+			);
+			if( elapsed >= stats_interval )
+			{
+				StatsRecord stats;
+				CollectStats( stats );
+				std::lock_guard<std::mutex> lock( stats_mutex );
+				published_stats.counters.swap( stats.counters );
+				for( size_t k = 0; k < STATS_HISTOGRAM_COUNT; ++k )
+					published_stats.histograms[k].swap( stats.histograms[k] );
+
+				published_stats.clients.swap( stats.clients );
+				stats_dirty = false;
+				stats_time = now;
+			}
+			else if( timeout < 0 || stats_interval - elapsed < timeout )
+				timeout = stats_interval - elapsed;
+		}
+
+		writer_sleeping.store( true, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+		if( !queue.Empty( ) )
+			continue;
+
+		if( !transport->Wait( timeout ) )
+			break;
+	}
+
+	Flush( );
+}
+
+void Server::Append( const uint8_t *data, size_t size )
+{
+	const uint64_t start = Clock::Ticks( );
+	flush_ticks = 0;
+
+	CaptureRecord capture;
+	LoadFields( data, capture );
+	const int32_t type = capture.type;
+	const int32_t level = capture.level;
+	const uint32_t group = capture.group;
+	const int32_t color = capture.color;
+	const uint64_t sequence = capture.sequence;
+	const uint64_t time = clock.ToNanoseconds( capture.ticks );
+	const char *message = reinterpret_cast<const char *>( data ) + capture_header_size;
+	const size_t message_length = size - capture_header_size;
+	++stats_counters[STATS_RECORDS];
+	stats_counters[STATS_RECORD_BYTES] += message_length;
+
+	// records the queue had no room for are reported to every console
+	const uint64_t queue_dropped = queue.Dropped( );
+	const uint64_t lost = queue_dropped - reported_drops;
+	reported_drops = queue_dropped;
+
+	if( group != GroupTable::invalid_group &&
+		group >= interest_group_count.load( std::memory_order_relaxed ) )
+		InvalidateInterest( );
+
+	// channels can be added while flushing, but never removed
+	for( size_t k = 0; k < channels.size( ); ++k )
+	{
+		Channel &channel = *channels[k];
+		if( !IsChannelUsed( channel ) )
+			continue;
+
+		const bool matches = channel.Matches( type, level, group, message, message_length );
+		if( !matches && lost == 0 )
+			continue;
+
+		size_t needed = 0;
+		if( matches )
+			needed += max_spew_record_size + message_length;
+
+		if( lost != 0 )
+			needed += record_header_size + sizeof( uint64_t );
+
+		if( !channel.IsEmpty( ) && channel.GetSize( ) + needed > server_options.batch_bytes )
+			FlushChannel( channel );
+
+		if( lost != 0 )
+			channel.AppendGap( lost );
+
+		if( matches )
+		{
+			channel.AppendSpew( type, level, group, color, sequence, time, message, message_length );
+			if( group != GroupTable::invalid_group && group >= batch_groups )
+				batch_groups = group + 1;
+		}
+
+		if( channel.GetRecords( ) >= server_options.batch_records ||
+			channel.GetSize( ) >= server_options.batch_bytes )
+			FlushChannel( channel );
+	}
+
+	encode_latency.Add( Clock::Ticks( ) - start - flush_ticks );
+}
+
+void Server::Flush( )
+{
+	for( size_t k = 0; k < channels.size( ); ++k )
+		FlushChannel( *channels[k] );
+}
+
+void Server::FlushChannel( Channel &channel )
+{
+	if( channel.IsEmpty( ) )
+		return;
+
+	const uint64_t start = Clock::Ticks( );
+	size_t size = 0;
+	const uint8_t *data = channel.Finish( size );
+
+	// only the channel receiving everything feeds the ring and the history,
+	// which shares the frame with the clients that queue it
+	const bool everything = channel.GetFilter( ) == nullptr;
+	if( everything && shared_ring.IsOpen( ) )
+		PublishShared( data, size );
+
+	FramePtr frame;
+	Broadcast( channel, data, size, frame );
+
+	// consoles that connect while waiting on the broadcast get the frame
+	// live, so it only becomes history afterwards
+	if( everything && history.IsEnabled( ) )
+	{
+		if( !frame )
+			frame = std::make_shared<Frame>( data, size );
+
+		history.Add( frame );
+	}
+
+	channel.Clear( );
+	flush_ticks += Clock::Ticks( ) - start;
+}
+
+void Server::Broadcast( Channel &channel, const uint8_t *data, size_t size, FramePtr &frame )
+{
+	WaitForClients( channel, size );
+
+	// consoles that lose this frame also lose the gaps it reports
+	const uint32_t records = channel.GetFrameRecords( );
+	FramePtr compressed_frame;
+	bool compress_attempted = false, compress_succeeded = false;
+	for( size_t k = 0; k < clients.size( ); )
+	{
+		Client &client = *clients[k];
+		if( client.GetChannel( ) != &channel )
+		{
+			++k;
+			continue;
+		}
+
+		bool open = true;
+		if( client.GetKnownGroups( ) < batch_groups )
+			open = SendGroups( client, batch_groups );
+
+		if( open && ( client.GetFeatures( ) & FEATURE_COMPRESSION ) != 0 && size >= min_compress_size )
+		{
+			// compressed once, the first time a client wants it
+			if( !compress_attempted )
+			{
+				compress_attempted = true;
+				compressed.Clear( );
+				compress_succeeded = EncodeCompressedFrame(
+					compressed,
+					data + frame_header_size,
+					size - frame_header_size,
+					encoder
+				);
+			}
+
+			if( compress_succeeded )
+				open = client.Send(
+					compressed.GetBuffer( ),
+					static_cast<size_t>( compressed.Size( ) ),
+					records,
+					compressed_frame
+				);
+			else
+				open = client.Send( data, size, records, frame );
+		}
+		else if( open )
+			open = client.Send( data, size, records, frame );
+
+		if( !open )
+		{
+			transport->Disconnect( client.GetConnection( ) );
+			RemoveClient( clients.begin( ) + k );
+		}
+		else
+			++k;
+	}
+}
+
+bool Server::SendGroups( Client &client, uint32_t count )
+{
+	definitions.Clear( );
+	EncodeFrameHeader( definitions, 0, 0 );
+	for( uint32_t group = client.GetKnownGroups( ); group < count; ++group )
+	{
+		const std::string *name = groups.Find( group );
+		EncodeGroupRecord( definitions, group, name->data( ), name->size( ) );
+	}
+
+	const size_t size = static_cast<size_t>( definitions.Size( ) );
+	definitions.Seek( 0 );
+	EncodeFrameHeader( definitions, 0, static_cast<uint32_t>( size - frame_header_size ) );
+
+	// definitions differ between clients, so the frame is never shared, and
+	// they can't be dropped without making later records useless
+	FramePtr frame;
+	if( !client.Send( definitions.GetBuffer( ), size, 0, frame, true ) )
+		return false;
+
+	client.SetKnownGroups( count );
+	return true;
+}
+
+void Server::SendStats( Client &client )
+{
+	StatsRecord stats;
+	CollectStats( stats );
+
+	MultiLibrary::ByteBuffer buffer;
+	EncodeFrameHeader( buffer, 0, 0 );
+	EncodeStatsRecord( buffer, stats );
+	const size_t size = static_cast<size_t>( buffer.Size( ) );
+	buffer.Seek( 0 );
+	EncodeFrameHeader( buffer, 0, static_cast<uint32_t>( size - frame_header_size ) );
+
+	// answers count against the console's budget like any frame, so one that
+	// keeps asking without reading can't grow its queue without end; a closed
+	// connection is noticed by the transport, which tells us later
+	FramePtr frame;
+	client.Send( buffer.GetBuffer( ), size, 0, frame );
+}
+
+void Server::CollectStats( StatsRecord &stats ) const
+{
+	stats.counters.assign( stats_counters, stats_counters + STATS_COUNTER_COUNT );
+	stats.counters[STATS_QUEUE_DROPS] = queue.Dropped( );
+
+	stats.clients.resize( clients.size( ) );
+	for( size_t k = 0; k < clients.size( ); ++k )
+	{
+		const Client &client = *clients[k];
+		const ClientCounters &counters = client.GetCounters( );
+		stats.counters[STATS_CLIENT_DROPS] += client.GetDropped( );
+		stats.counters[STATS_FRAMES] += counters.frames;
+		stats.counters[STATS_FRAME_BYTES] += counters.bytes;
+		stats.counters[STATS_BLOCKED_WRITES] += counters.blocked_writes;
+		stats.counters[STATS_WRITE_ERRORS] += counters.write_errors;
+
+		ClientStats &client_stats = stats.clients[k];
+		client_stats.queued_frames = static_cast<uint32_t>( client.GetQueuedFrames( ) );
+		client_stats.queued_bytes = client.GetQueuedBytes( );
+		client_stats.dropped = client.GetDropped( );
+		client_stats.policy = static_cast<uint8_t>( client.GetPolicy( ).policy );
+	}
+
+	// bucket limits are powers of two in ticks, and only turned into time here
+	const Histogram *histograms[STATS_HISTOGRAM_COUNT] = {
+		&encode_latency,
+		&enqueue_latency,
+		&write_latency
+	};
+	for( size_t k = 0; k < STATS_HISTOGRAM_COUNT; ++k )
+	{
+		stats.histograms[k].clear( );
+		for( size_t bucket = 0; bucket < Histogram::bucket_count; ++bucket )
+		{
+			LatencyBucket latency;
+			latency.count = histograms[k]->GetBucket( bucket );
+			latency.limit = clock.ToDuration( uint64_t( 1 ) << bucket );
+			if( latency.count != 0 )
+				stats.histograms[k].push_back( latency );
+		}
+	}
+}
+
+bool Server::SendHistory( Client &client )
+{
+	const std::deque<FramePtr> &frames = history.GetFrames( );
+	if( frames.empty( ) )
+		return true;
+
+	if( client.GetKnownGroups( ) < batch_groups && !SendGroups( client, batch_groups ) )
+		return false;
+
+	// queued back to back ahead of anything live, without copying them
+	for( const FramePtr &history_frame : frames )
+	{
+		FramePtr frame = history_frame;
+		if( !client.Send( frame->GetData( ), frame->GetSize( ), 0, frame, true ) )
+			return false;
+	}
+
+	if( !history_end )
+	{
+		uint8_t data[frame_header_size + record_header_size];
+		MultiLibrary::MemoryBuffer buffer( data, sizeof( data ) );
+		EncodeFrameHeader( buffer, 0, record_header_size );
+		EncodeRecordHeader( buffer, RECORD_HISTORY_END, 0 );
+		history_end = std::make_shared<Frame>( data, sizeof( data ) );
+	}
+
+	FramePtr frame = history_end;
+	return client.Send( frame->GetData( ), frame->GetSize( ), 0, frame, true );
+}
+
+void Server::PublishShared( const uint8_t *data, size_t size )
+{
+	for( uint32_t group = shared_ring.GetGroupCount( ); group < batch_groups; ++group )
+	{
+		const std::string *name = groups.Find( group );
+		shared_ring.DefineGroup( group, name->data( ), name->size( ) );
+	}
+
+	shared_ring.Publish( data, size );
+}
+
+void Server::WaitForClients( Channel &channel, size_t size )
+{
+	// consoles that asked to hold the server get some time to catch up
+	const auto start = std::chrono::steady_clock::now( );
+	while( true )
+	{
+		int timeout = -1;
+		const int elapsed = static_cast<int>(
+			std::chrono::duration_cast<std::chrono::milliseconds>(
+				std::chrono::steady_clock::now( ) - start
+			).count( )
+		);
+		for( const std::unique_ptr<Client> &client : clients )
+		{
+			const ClientPolicy &policy = client->GetPolicy( );
+			if( client->GetChannel( ) != &channel || policy.policy != POLICY_BLOCK || !client->IsOverBudget( size ) ||
+				elapsed >= policy.block_timeout )
+				continue;
+
+			const int remaining = policy.block_timeout - elapsed;
+			if( timeout < 0 || remaining < timeout )
+				timeout = remaining;
+		}
+
+		// connection events are handled while waiting, which is how the
+		// clients we wait for make progress
+		if( timeout < 0 || !transport->Wait( timeout ) )
+			return;
+	}
+}
+
+bool Server::IsChannelUsed( const Channel &channel ) const
+{
+	if( channel.GetSubscribers( ) != 0 )
+		return true;
+
+	return channel.GetFilter( ) == nullptr && ( history.IsEnabled( ) || shared_ring.HasReaders( ) );
+}
+
+void Server::Subscribe( Client &client, const SubscribeRecord &subscription )
+{
+	Channel *channel = nullptr;
+	if( subscription.IsEverything( ) )
+		channel = channels.front( ).get( );
+
+	// consoles with the same subscription share a channel, and its frames
+	for( size_t k = 1; k < channels.size( ) && channel == nullptr; ++k )
+		if( channels[k]->GetFilter( )->GetSubscription( ) == subscription )
+			channel = channels[k].get( );
+
+	if( channel == nullptr )
+	{
+		std::unique_ptr<Filter> filter( new Filter( subscription, groups, stats_counters[STATS_FILTER_ERRORS] ) );
+		if( !filter->IsValid( ) )
+			return;
+
+		channels.emplace_back( new Channel( filter.release( ), server_options.batch_bytes ) );
+		channel = channels.back( ).get( );
+	}
+
+	SetChannel( client, channel );
+}
+
+void Server::SetChannel( Client &client, Channel *channel )
+{
+	if( client.GetChannel( ) != nullptr )
+		client.GetChannel( )->RemoveSubscriber( );
+
+	if( channel != nullptr )
+		channel->AddSubscriber( );
+
+	client.SetChannel( channel );
+	InvalidateInterest( );
+}
+
+void Server::InvalidateInterest( )
+{
+	// everything is wanted until the writer rebuilds the summary
+	interest_all.store( true, std::memory_order_relaxed );
+	channels_changed = true;
+}
+
+void Server::UpdateInterest( )
+{
+	interest_all.store( true, std::memory_order_relaxed );
+
+	// groups added later are let through by IsWanted
+	const uint32_t group_count = groups.Size( );
+	interest_group_count.store( group_count, std::memory_order_relaxed );
+	if( history.IsEnabled( ) || channels.front( )->GetSubscribers( ) != 0 )
+		return;
+
+	uint32_t types = 0;
+	int32_t level = INT32_MAX;
+	uint64_t group_bits[GroupTable::max_groups / 64] = { };
+	for( size_t k = 1; k < channels.size( ); ++k )
+	{
+		if( channels[k]->GetSubscribers( ) == 0 )
+			continue;
+
+		Filter &filter = *channels[k]->GetFilter( );
+		const SubscribeRecord &subscription = filter.GetSubscription( );
+		types |= subscription.type_mask;
+		level = std::min( level, subscription.min_level );
+		for( uint32_t group = 0; group < group_count; ++group )
+			if( filter.WantsGroup( group ) )
+				group_bits[group / 64] |= uint64_t( 1 ) << ( group % 64 );
+	}
+
+	interest_types.store( types, std::memory_order_relaxed );
+	interest_level.store( level, std::memory_order_relaxed );
+	for( uint32_t k = 0; k < GroupTable::max_groups / 64; ++k )
+		interest_groups[k].store( group_bits[k], std::memory_order_relaxed );
+
+	interest_all.store( false, std::memory_order_release );
+}
+
+std::vector<std::unique_ptr<Client>>::iterator Server::FindClient( Connection *connection )
+{
+	for( auto it = clients.begin( ); it != clients.end( ); ++it )
+		if( ( *it )->GetConnection( ) == connection )
+			return it;
+
+	return clients.end( );
+}
+
+void Server::RemoveClient( std::vector<std::unique_ptr<Client>>::iterator it )
+{
+	// what gone clients did still counts
+	const ClientCounters &counters = ( *it )->GetCounters( );
+	stats_counters[STATS_CLIENT_DROPS] += ( *it )->GetDropped( );
+	stats_counters[STATS_FRAMES] += counters.frames;
+	stats_counters[STATS_FRAME_BYTES] += counters.bytes;
+	stats_counters[STATS_BLOCKED_WRITES] += counters.blocked_writes;
+	stats_counters[STATS_WRITE_ERRORS] += counters.write_errors;
+	++stats_counters[STATS_DISCONNECTS];
+
+	SetChannel( **it, nullptr );
+
+	// order doesn't matter, so swap with the last one to avoid shifting
+	std::swap( *it, clients.back( ) );
+	clients.pop_back( );
+	client_count = clients.size( );
+}
+
+void Server::OnConnect( Connection *connection )
+{
+	++stats_counters[STATS_CONNECTS];
+	clients.emplace_back( new Client( connection, server_options.client_policy, write_latency ) );
+	SetChannel( *clients.back( ), channels.front( ).get( ) );
+	if( !SendHistory( *clients.back( ) ) )
+	{
+		transport->Disconnect( connection );
+		RemoveClient( clients.end( ) - 1 );
+	}
+
+	client_count = clients.size( );
+}
+
+void Server::OnDisconnect( Connection *connection )
+{
+	auto it = FindClient( connection );
+	if( it != clients.end( ) )
+		RemoveClient( it );
+}
+
+void Server::OnWritable( Connection *connection )
+{
+	auto it = FindClient( connection );
+	if( it == clients.end( ) )
+		return;
+
+	( *it )->SetWritable( );
+	if( !( *it )->Flush( ) )
+	{
+		transport->Disconnect( connection );
+		RemoveClient( it );
+	}
+}
+
+void Server::OnReceive( Connection *connection, const uint8_t *data, size_t size )
+{
+	auto it = FindClient( connection );
+	if( it == clients.end( ) )
+		return;
+
+	// consoles only send small control frames, anything odd is ignored
+	MultiLibrary::MemoryBuffer stream( const_cast<uint8_t *>( data ), size );
+	FrameHeader frame_header;
+	MultiLibrary::ByteBuffer records;
+	if( !DecodeFrame( stream, frame_header, records, max_receive_size ) )
+		return;
+
+	RecordHeader record_header;
+	while( records.Tell( ) < records.Size( ) && DecodeRecordHeader( records, record_header ) )
+	{
+		if( record_header.kind == RECORD_HELLO )
+		{
+			HelloRecord hello;
+			if( !DecodeHelloRecord( records, record_header, hello ) )
+				break;
+
+			uint32_t features = hello.features & FEATURE_COMPRESSION;
+			if( !server_options.compression )
+				features &= ~static_cast<uint32_t>( FEATURE_COMPRESSION );
+
+			( *it )->SetFeatures( features );
+			if( hello.has_policy && hello.policy < POLICY_COUNT )
+				( *it )->SetPolicy( LimitPolicy( hello, server_options.client_policy ) );
+		}
+		else if( record_header.kind == RECORD_STATS )
+		{
+			if( !SkipRecord( records, record_header ) )
+				break;
+
+			SendStats( **it );
+		}
+		else if( record_header.kind == RECORD_SUBSCRIBE )
+		{
+			// subscriptions that can't be compiled are ignored
+			SubscribeRecord subscription;
+			if( !DecodeSubscribeRecord( records, record_header, subscription ) )
+				break;
+
+			Subscribe( **it, subscription );
+		}
+		else if( !SkipRecord( records, record_header ) )
+			break;
+	}
+}
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <ByteBuffer.hpp>
+#include <Channel.hpp>
+#include <Client.hpp>
+#include <Clock.hpp>
+#include <GroupTable.hpp>
+#include <History.hpp>
+#include <Protocol.hpp>
+#include <SharedRing.hpp>
+#include <SpewQueue.hpp>
+#include <Stats.hpp>
+#include <Transport.hpp>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace xconsole
+{
+
+/*!
+ \brief Settings that control how records are batched into frames.
+ */
+struct ServerOptions
+{
+	ServerOptions( );
+
+	size_t batch_bytes; ///< Frames are flushed once they reach this size
+	size_t batch_records; ///< Frames are flushed once they hold this many records
+	int flush_interval; ///< Milliseconds a frame can wait for more records
+	bool low_latency; ///< Flush as soon as the queue runs empty, without waiting
+	bool compression; ///< Compress frames for consoles that ask for it
+	ClientPolicy client_policy; ///< Default policy, and limits for those consoles ask for
+	std::string shared_name; ///< Name of the shared memory ring, empty to disable it
+	size_t shared_size; ///< Size of the shared memory ring
+	size_t history_size; ///< Bytes of recent frames sent to new consoles, 0 to disable
+};
+
+/*!
+ \brief Moves records from the game to every connected console.
+
+ Records are pushed into a lock-free queue and drained by a dedicated thread,
+ which packs them into frames and writes those out, so the threads producing
+ records never wait on consoles.
+ */
+class Server : private TransportHandler
+{
+public:
+	Server( );
+	~Server( );
+
+	/*!
+	 \brief Open the transport and start the writer thread.
+
+	 \param path Platform specific address to listen on.
+	 \param options Batching settings.
+
+	 \return true if it succeeds, false if it fails.
+	 */
+	bool Start( const std::string &path, const ServerOptions &options );
+
+	/*!
+	 \brief Stop the writer thread and close the transport.
+	 */
+	void Stop( );
+
+	/*!
+	 \brief Tell if records are wanted, by a connected console, a shared
+	 memory reader or the history.
+
+	 \return true if records should be queued, false otherwise.
+	 */
+	bool WantsRecords( ) const;
+
+	/*!
+	 \brief Queue a line of console output to be sent.
+
+	 Safe to call from any thread. Groups are interned here, so nothing is
+	 allocated once every group has been seen. Records no subscription can
+	 match are skipped before being queued. Records are stamped with the
+	 current time and the next sequence number.
+
+	 \param type Spew type.
+	 \param level Spew level.
+	 \param group Spew group name.
+	 \param color Raw spew color.
+	 \param message Message text.
+
+	 \return true if it succeeds or nobody wants the record, false if the
+	 record was dropped.
+	 */
+	bool Capture( int32_t type, int32_t level, const char *group, int32_t color, const char *message );
+
+	/*!
+	 \brief Return the latest statistics.
+
+	 Safe to call from any thread. The writer thread refreshes them up to ten
+	 times per second, while things are happening.
+
+	 \param stats Where to store the statistics.
+	 */
+	void GetStats( StatsRecord &stats ) const;
+
+private:
+	bool IsWanted( int32_t type, int32_t level, uint32_t group ) const;
+	void WakeWriter( );
+	void WriterThread( );
+	void Append( const uint8_t *data, size_t size );
+	void Flush( );
+	void FlushChannel( Channel &channel );
+	void Broadcast( Channel &channel, const uint8_t *data, size_t size, FramePtr &frame );
+	bool SendHistory( Client &client );
+	void PublishShared( const uint8_t *data, size_t size );
+	void WaitForClients( Channel &channel, size_t size );
+	bool IsChannelUsed( const Channel &channel ) const;
+	void Subscribe( Client &client, const SubscribeRecord &subscription );
+	void SetChannel( Client &client, Channel *channel );
+	void InvalidateInterest( );
+	void UpdateInterest( );
+	bool SendGroups( Client &client, uint32_t count );
+	void SendStats( Client &client );
+	void CollectStats( StatsRecord &stats ) const;
+	std::vector<std::unique_ptr<Client>>::iterator FindClient( Connection *connection );
+	void RemoveClient( std::vector<std::unique_ptr<Client>>::iterator it );
+
+	void OnConnect( Connection *connection );
+	void OnDisconnect( Connection *connection );
+	void OnWritable( Connection *connection );
+	void OnReceive( Connection *connection, const uint8_t *data, size_t size );
+
+	std::unique_ptr<Transport> transport;
+	ServerOptions server_options;
+	SpewQueue queue;
+	GroupTable groups;
+	Clock clock;
+	std::atomic<uint64_t> capture_sequence;
+	SharedRing shared_ring;
+	History history;
+	FramePtr history_end;
+	std::atomic<bool> writer_sleeping;
+	std::atomic<size_t> client_count;
+	std::vector<std::unique_ptr<Client>> clients;
+	std::vector<std::unique_ptr<Channel>> channels; ///< The first one receives everything
+	bool channels_changed;
+	uint64_t reported_drops;
+	uint32_t batch_groups;
+	MultiLibrary::ByteBuffer definitions;
+	MultiLibrary::ByteBuffer compressed;
+	Lz4Encoder encoder;
+	std::thread writer_thread;
+
+	Histogram encode_latency;
+	Histogram enqueue_latency;
+	Histogram write_latency;
+	uint64_t stats_counters[STATS_COUNTER_COUNT]; ///< Includes the clients that are gone
+	uint64_t flush_ticks; ///< Spent flushing, left out of the encoding latency
+	bool stats_dirty;
+	std::chrono::steady_clock::time_point stats_time;
+	mutable std::mutex stats_mutex;
+	StatsRecord published_stats;
+
+	// union of every subscription, checked before records are queued
+	std::atomic<bool> interest_all;
+	std::atomic<uint32_t> interest_types;
+	std::atomic<int32_t> interest_level;
+	std::atomic<uint32_t> interest_group_count;
+	std::atomic<uint64_t> interest_groups[GroupTable::max_groups / 64];
+};
+
+} // namespace xconsole
\ No newline at end of file
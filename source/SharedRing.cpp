@@ -0,0 +1,512 @@
+#include <SharedRing.hpp>
+#include <MemoryBuffer.hpp>
+#include <Protocol.hpp>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#if defined __linux__
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace xconsole
+{
+
+static const size_t region_header_size = 256;
+static const size_t dictionary_capacity = 64 * 1024;
+static const uint64_t entry_header_size = sizeof( uint32_t ) * 2;
+static const uint32_t padding_entry = 1;
+
+static_assert( sizeof( SharedRingHeader ) <= region_header_size, "shared ring header is too large" );
+
+static uint64_t EntrySize( uint64_t size )
+{
+	return ( entry_header_size + size + 7 ) & ~uint64_t( 7 );
+}
+
+SharedRegion::SharedRegion( ) :
+	region( nullptr ),
+	region_size( 0 ),
+	region_owner( false )
+#if defined _WIN32
+	,
+	mapping( nullptr ),
+	wake_semaphore( nullptr )
+#endif
+{ }
+
+SharedRegion::~SharedRegion( )
+{
+	Unmap( );
+}
+
+#if defined _WIN32
+
+bool SharedRegion::Map( const std::string &name, size_t size )
+{
+	SECURITY_DESCRIPTOR sd;
+	InitializeSecurityDescriptor( &sd, SECURITY_DESCRIPTOR_REVISION );
+	SetSecurityDescriptorDacl( &sd, TRUE, nullptr, FALSE );
+
+	SECURITY_ATTRIBUTES sa;
+	sa.nLength = sizeof( sa );
+	sa.lpSecurityDescriptor = &sd;
+	sa.bInheritHandle = FALSE;
+
+	if( size != 0 )
+		mapping = CreateFileMappingA(
+			INVALID_HANDLE_VALUE,
+			&sa,
+			PAGE_READWRITE,
+			static_cast<DWORD>( static_cast<uint64_t>( size ) >> 32 ),
+			static_cast<DWORD>( size ),
+			name.c_str( )
+		);
+	else
+		mapping = OpenFileMappingA( FILE_MAP_ALL_ACCESS, FALSE, name.c_str( ) );
+
+	if( mapping == nullptr )
+		return false;
+
+	region = static_cast<uint8_t *>( MapViewOfFile( mapping, FILE_MAP_ALL_ACCESS, 0, 0, size ) );
+	wake_semaphore = CreateSemaphoreA( &sa, 0, LONG_MAX, ( name + "_wake" ).c_str( ) );
+	if( region == nullptr || wake_semaphore == nullptr )
+	{
+		Unmap( );
+		return false;
+	}
+
+	region_name = name;
+	region_size = size;
+	region_owner = size != 0;
+	return true;
+}
+
+void SharedRegion::Unmap( )
+{
+	// the mapping goes away with its last handle
+	if( region != nullptr )
+	{
+		UnmapViewOfFile( region );
+		region = nullptr;
+	}
+
+	if( wake_semaphore != nullptr )
+	{
+		CloseHandle( wake_semaphore );
+		wake_semaphore = nullptr;
+	}
+
+	if( mapping != nullptr )
+	{
+		CloseHandle( mapping );
+		mapping = nullptr;
+	}
+
+	region_name.clear( );
+	region_size = 0;
+	region_owner = false;
+}
+
+void SharedRegion::WakeAll( )
+{
+	const LONG waiters = static_cast<LONG>(
+		GetHeader( )->waiters.load( std::memory_order_relaxed )
+	);
+	if( waiters != 0 )
+		ReleaseSemaphore( wake_semaphore, waiters, nullptr );
+}
+
+void SharedRegion::Wait( uint32_t, int timeout )
+{
+	// extra releases only cause spurious wake ups, the semaphore counts them
+	WaitForSingleObject( wake_semaphore, timeout < 0 ? INFINITE : static_cast<DWORD>( timeout ) );
+}
+
+#elif defined __linux__
+
+bool SharedRegion::Map( const std::string &name, size_t size )
+{
+	const std::string path = name[0] == '/' ? name : "/" + name;
+	const bool create = size != 0;
+
+	int fd = -1;
+	if( create )
+	{
+		// a previous process might have left its region behind
+		shm_unlink( path.c_str( ) );
+		fd = shm_open( path.c_str( ), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0666 );
+		if( fd == -1 )
+			return false;
+
+		fchmod( fd, 0666 );
+		if( ftruncate( fd, static_cast<off_t>( size ) ) == -1 )
+		{
+			close( fd );
+			shm_unlink( path.c_str( ) );
+			return false;
+		}
+	}
+	else
+	{
+		fd = shm_open( path.c_str( ), O_RDWR | O_CLOEXEC, 0 );
+		struct stat status;
+		if( fd == -1 || fstat( fd, &status ) == -1 )
+		{
+			if( fd != -1 )
+				close( fd );
+
+			return false;
+		}
+
+		size = static_cast<size_t>( status.st_size );
+	}
+
+	void *address = mmap( nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	close( fd );
+	if( address == MAP_FAILED )
+	{
+		if( create )
+			shm_unlink( path.c_str( ) );
+
+		return false;
+	}
+
+	region = static_cast<uint8_t *>( address );
+	region_name = path;
+	region_size = size;
+	region_owner = create;
+	return true;
+}
+
+void SharedRegion::Unmap( )
+{
+	if( region == nullptr )
+		return;
+
+	munmap( region, region_size );
+	if( region_owner )
+		shm_unlink( region_name.c_str( ) );
+
+	region = nullptr;
+	region_name.clear( );
+	region_size = 0;
+	region_owner = false;
+}
+
+void SharedRegion::WakeAll( )
+{
+	syscall(
+		SYS_futex,
+		reinterpret_cast<uint32_t *>( &GetHeader( )->sequence ),
+		FUTEX_WAKE,
+		INT_MAX,
+		nullptr,
+		nullptr,
+		0
+	);
+}
+
+void SharedRegion::Wait( uint32_t sequence, int timeout )
+{
+	timespec time;
+	time.tv_sec = timeout / 1000;
+	time.tv_nsec = static_cast<long>( timeout % 1000 ) * 1000000;
+
+	// returns right away if the sequence already changed
+	syscall(
+		SYS_futex,
+		reinterpret_cast<uint32_t *>( &GetHeader( )->sequence ),
+		FUTEX_WAIT,
+		sequence,
+		timeout < 0 ? nullptr : &time,
+		nullptr,
+		0
+	);
+}
+
+#endif
+
+SharedRingHeader *SharedRegion::GetHeader( ) const
+{
+	return reinterpret_cast<SharedRingHeader *>( region );
+}
+
+SharedRing::SharedRing( ) :
+	header( nullptr ),
+	dictionary( nullptr ),
+	ring( nullptr ),
+	ring_capacity( 0 ),
+	write_position( 0 ),
+	start_position( 0 ),
+	dictionary_size( 0 ),
+	group_count( 0 )
+{ }
+
+SharedRing::~SharedRing( )
+{
+	Close( );
+}
+
+bool SharedRing::Open( const std::string &name, size_t capacity )
+{
+	uint64_t size = 4096;
+	while( size < capacity )
+		size <<= 1;
+
+	if( !shared_region.Map( name, region_header_size + dictionary_capacity + static_cast<size_t>( size ) ) )
+		return false;
+
+	uint8_t *region = reinterpret_cast<uint8_t *>( shared_region.GetHeader( ) );
+	header = new( region ) SharedRingHeader( );
+	header->version = shared_ring_version;
+	header->capacity = size;
+	header->dictionary_capacity = dictionary_capacity;
+	header->write_position.store( 0, std::memory_order_relaxed );
+	header->start_position.store( 0, std::memory_order_relaxed );
+	header->dictionary_size.store( 0, std::memory_order_relaxed );
+	header->sequence.store( 0, std::memory_order_relaxed );
+	header->waiters.store( 0, std::memory_order_relaxed );
+	header->readers.store( 0, std::memory_order_relaxed );
+	dictionary = region + region_header_size;
+	ring = dictionary + dictionary_capacity;
+	ring_capacity = size;
+	write_position = 0;
+	start_position = 0;
+	dictionary_size = 0;
+	entry_ends.clear( );
+	group_count = 0;
+
+	// readers only trust the rest of the header once the magic shows up
+	std::atomic_thread_fence( std::memory_order_release );
+	header->magic = shared_ring_magic;
+	return true;
+}
+
+void SharedRing::Close( )
+{
+	if( header == nullptr )
+		return;
+
+	header = nullptr;
+	dictionary = nullptr;
+	ring = nullptr;
+	ring_capacity = 0;
+	write_position = 0;
+	start_position = 0;
+	dictionary_size = 0;
+	entry_ends.clear( );
+	group_count = 0;
+	shared_region.Unmap( );
+}
+
+bool SharedRing::IsOpen( ) const
+{
+	return header != nullptr;
+}
+
+bool SharedRing::HasReaders( ) const
+{
+	return header != nullptr && header->readers.load( std::memory_order_relaxed ) != 0;
+}
+
+void SharedRing::DefineGroup( uint32_t group, const char *name, size_t length )
+{
+	++group_count;
+
+	// groups that don't fit are left unnamed
+	const uint64_t record_size = record_header_size + sizeof( group ) + length;
+	if( dictionary_size + record_size > dictionary_capacity )
+		return;
+
+	MultiLibrary::MemoryBuffer buffer( dictionary + dictionary_size, static_cast<size_t>( record_size ) );
+	EncodeGroupRecord( buffer, group, name, length );
+	dictionary_size += record_size;
+	header->dictionary_size.store( dictionary_size, std::memory_order_release );
+}
+
+bool SharedRing::Publish( const uint8_t *data, size_t size )
+{
+	// readers can write to the region, so the layout is only ever taken from
+	// our own copy of it and nothing in the region is read back
+	const uint64_t total = EntrySize( size );
+	if( total > ring_capacity )
+		return false;
+
+	const uint64_t remaining = ring_capacity - ( write_position & ( ring_capacity - 1 ) );
+	const uint64_t padding = total > remaining ? remaining : 0;
+
+	// move past the frames we're about to overwrite before touching them
+	while( write_position + padding + total - start_position > ring_capacity )
+	{
+		start_position = entry_ends.front( );
+		entry_ends.pop_front( );
+	}
+
+	header->start_position.store( start_position, std::memory_order_relaxed );
+	std::atomic_thread_fence( std::memory_order_release );
+
+	if( padding != 0 )
+	{
+		uint8_t *entry = ring + ( write_position & ( ring_capacity - 1 ) );
+		const uint32_t entry_size = static_cast<uint32_t>( padding );
+		std::memcpy( entry, &entry_size, sizeof( entry_size ) );
+		std::memcpy( entry + sizeof( entry_size ), &padding_entry, sizeof( padding_entry ) );
+		write_position += padding;
+		entry_ends.push_back( write_position );
+	}
+
+	uint8_t *entry = ring + ( write_position & ( ring_capacity - 1 ) );
+	const uint32_t entry_size = static_cast<uint32_t>( size );
+	const uint32_t entry_flags = 0;
+	std::memcpy( entry, &entry_size, sizeof( entry_size ) );
+	std::memcpy( entry + sizeof( entry_size ), &entry_flags, sizeof( entry_flags ) );
+	std::memcpy( entry + entry_header_size, data, size );
+	write_position += total;
+	entry_ends.push_back( write_position );
+	header->write_position.store( write_position, std::memory_order_release );
+
+	// pairs with SharedRingReader::Wait, either we see the waiter or it sees
+	// the new sequence
+	header->sequence.fetch_add( 1, std::memory_order_seq_cst );
+	if( header->waiters.load( std::memory_order_seq_cst ) != 0 )
+		shared_region.WakeAll( );
+
+	return true;
+}
+
+uint32_t SharedRing::GetGroupCount( ) const
+{
+	return group_count;
+}
+
+SharedRingReader::SharedRingReader( ) :
+	header( nullptr ),
+	dictionary( nullptr ),
+	ring( nullptr ),
+	read_position( 0 ),
+	overruns( 0 )
+{ }
+
+SharedRingReader::~SharedRingReader( )
+{
+	Close( );
+}
+
+bool SharedRingReader::Open( const std::string &name )
+{
+	if( !shared_region.Map( name, 0 ) )
+		return false;
+
+	header = shared_region.GetHeader( );
+	if( header->magic != shared_ring_magic || header->version != shared_ring_version )
+	{
+		header = nullptr;
+		shared_region.Unmap( );
+		return false;
+	}
+
+	std::atomic_thread_fence( std::memory_order_acquire );
+	const uint8_t *region = reinterpret_cast<const uint8_t *>( header );
+	dictionary = region + region_header_size;
+	ring = dictionary + header->dictionary_capacity;
+	read_position = header->start_position.load( std::memory_order_acquire );
+	overruns = 0;
+	header->readers.fetch_add( 1, std::memory_order_relaxed );
+	return true;
+}
+
+void SharedRingReader::Close( )
+{
+	if( header == nullptr )
+		return;
+
+	header->readers.fetch_sub( 1, std::memory_order_relaxed );
+	header = nullptr;
+	dictionary = nullptr;
+	ring = nullptr;
+	shared_region.Unmap( );
+}
+
+bool SharedRingReader::Read( std::vector<uint8_t> &frame )
+{
+	const uint64_t capacity = header->capacity;
+	while( true )
+	{
+		if( read_position == header->write_position.load( std::memory_order_acquire ) )
+			return false;
+
+		const uint64_t start = header->start_position.load( std::memory_order_acquire );
+		if( read_position < start )
+		{
+			++overruns;
+			read_position = start;
+			continue;
+		}
+
+		const uint64_t offset = read_position & ( capacity - 1 );
+		const uint8_t *entry = ring + offset;
+		uint32_t entry_size, entry_flags;
+		std::memcpy( &entry_size, entry, sizeof( entry_size ) );
+		std::memcpy( &entry_flags, entry + sizeof( entry_size ), sizeof( entry_flags ) );
+
+		const bool padding = ( entry_flags & padding_entry ) != 0;
+		const uint64_t total = padding ? entry_size : EntrySize( entry_size );
+
+		// a torn header can claim anything, so check before copying
+		const bool sane = total >= entry_header_size && total <= capacity - offset;
+		if( sane && !padding )
+			frame.assign( entry + entry_header_size, entry + entry_header_size + entry_size );
+
+		// the copy is only good if the server didn't start overwriting it
+		std::atomic_thread_fence( std::memory_order_acquire );
+		const uint64_t current_start = header->start_position.load( std::memory_order_relaxed );
+		if( current_start > read_position )
+		{
+			++overruns;
+			read_position = current_start;
+			continue;
+		}
+
+		// garbage that wasn't overwritten means the region is corrupted
+		if( !sane )
+		{
+			++overruns;
+			read_position = header->write_position.load( std::memory_order_acquire );
+			return false;
+		}
+
+		read_position += total;
+		if( !padding )
+			return true;
+	}
+}
+
+void SharedRingReader::Wait( int timeout )
+{
+	header->waiters.fetch_add( 1, std::memory_order_seq_cst );
+	const uint32_t sequence = header->sequence.load( std::memory_order_seq_cst );
+	if( read_position == header->write_position.load( std::memory_order_seq_cst ) )
+		shared_region.Wait( sequence, timeout );
+
+	header->waiters.fetch_sub( 1, std::memory_order_relaxed );
+}
+
+void SharedRingReader::ReadDictionary( std::vector<uint8_t> &records ) const
+{
+	const uint64_t size = header->dictionary_size.load( std::memory_order_acquire );
+	records.assign( dictionary, dictionary + size );
+}
+
+uint64_t SharedRingReader::GetOverruns( ) const
+{
+	return overruns;
+}
+
+} // namespace xconsole
\ No newline at end of file
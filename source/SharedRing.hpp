@@ -0,0 +1,252 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#if defined _WIN32
+#include <Windows.h>
+#endif
+
+namespace xconsole
+{
+
+/*
+ A shared memory region, named after the console path, holds the header
+ below, followed by a dictionary of group records and a ring of frames.
+ Each frame in the ring starts with a uint32 size and a uint32 flag that
+ marks padding, which fills the end of the ring so frames never wrap.
+
+ The server never waits for readers: old frames are overwritten and
+ start_position moves past them before that happens. Readers check it
+ after copying a frame, to detect when they were overrun. The server only
+ writes the region, it keeps the layout of the ring to itself.
+ */
+
+static const uint32_t shared_ring_magic = 0x474E5258; // "XRNG"
+static const uint32_t shared_ring_version = 1;
+
+/*!
+ \brief Header at the start of the shared memory region.
+ */
+struct SharedRingHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t capacity; ///< Size of the ring, a power of two
+	uint64_t dictionary_capacity; ///< Size of the group dictionary
+	alignas( 64 ) std::atomic<uint64_t> write_position; ///< End of the newest frame
+	std::atomic<uint64_t> start_position; ///< Start of the oldest frame
+	std::atomic<uint64_t> dictionary_size; ///< Bytes of group records
+	alignas( 64 ) std::atomic<uint32_t> sequence; ///< Bumped on every frame, readers wait on it
+	std::atomic<uint32_t> waiters; ///< Readers currently waiting
+	std::atomic<uint32_t> readers; ///< Readers attached, might be stale after crashes
+};
+
+/*!
+ \brief A memory mapping and the wake up object of a shared ring.
+ */
+class SharedRegion
+{
+public:
+	SharedRegion( );
+	~SharedRegion( );
+
+	/*!
+	 \brief Create or open a region.
+
+	 \param name Name of the region.
+	 \param size Size of the region when creating it, 0 to open an existing
+	 one.
+
+	 \return true if it succeeds, false if it fails.
+	 */
+	bool Map( const std::string &name, size_t size );
+
+	/*!
+	 \brief Unmap the region, removing it if we created it.
+	 */
+	void Unmap( );
+
+	/*!
+	 \brief Return the header of the region.
+
+	 \return Pointer to the header, nullptr if nothing is mapped.
+	 */
+	SharedRingHeader *GetHeader( ) const;
+
+	/*!
+	 \brief Wake every waiting reader.
+	 */
+	void WakeAll( );
+
+	/*!
+	 \brief Wait until the sequence changes or the timeout expires.
+
+	 \param sequence Sequence value that was last seen.
+	 \param timeout Maximum time to wait in milliseconds, negative to wait
+	 forever.
+	 */
+	void Wait( uint32_t sequence, int timeout );
+
+private:
+	std::string region_name;
+	uint8_t *region;
+	size_t region_size;
+	bool region_owner;
+#if defined _WIN32
+	HANDLE mapping;
+	HANDLE wake_semaphore;
+#endif
+};
+
+/*!
+ \brief Publishes frames to any number of readers on the same host.
+
+ Every frame is copied once, readers read it straight from shared memory.
+ */
+class SharedRing
+{
+public:
+	SharedRing( );
+	~SharedRing( );
+
+	/*!
+	 \brief Create the shared memory region.
+
+	 \param name Name of the region.
+	 \param capacity Size of the ring, rounded up to a power of two.
+
+	 \return true if it succeeds, false if it fails.
+	 */
+	bool Open( const std::string &name, size_t capacity );
+
+	/*!
+	 \brief Remove the shared memory region.
+	 */
+	void Close( );
+
+	/*!
+	 \brief Tell if the ring is open.
+
+	 \return true if it is open, false otherwise.
+	 */
+	bool IsOpen( ) const;
+
+	/*!
+	 \brief Tell if any reader might be attached.
+
+	 \return true if a reader is attached, false otherwise.
+	 */
+	bool HasReaders( ) const;
+
+	/*!
+	 \brief Make a group known to readers.
+
+	 Groups must be defined in order and before any frame uses them.
+
+	 \param group Group identifier.
+	 \param name Group name.
+	 \param length Length of the group name, without terminator.
+	 */
+	void DefineGroup( uint32_t group, const char *name, size_t length );
+
+	/*!
+	 \brief Copy a frame into the ring, overwriting the oldest frames if
+	 needed, and wake waiting readers.
+
+	 \param data Frame data.
+	 \param size Size of the frame.
+
+	 \return false if the frame is larger than the ring, true otherwise.
+	 */
+	bool Publish( const uint8_t *data, size_t size );
+
+	/*!
+	 \brief Return the amount of groups defined so far.
+
+	 \return Amount of groups.
+	 */
+	uint32_t GetGroupCount( ) const;
+
+private:
+	SharedRegion shared_region;
+	SharedRingHeader *header;
+	uint8_t *dictionary;
+	uint8_t *ring;
+	uint64_t ring_capacity;
+	uint64_t write_position;
+	uint64_t start_position;
+	uint64_t dictionary_size;
+	std::deque<uint64_t> entry_ends; ///< End of every entry still in the ring
+	uint32_t group_count;
+};
+
+/*!
+ \brief Reads frames published by a SharedRing in another process.
+ */
+class SharedRingReader
+{
+public:
+	SharedRingReader( );
+	~SharedRingReader( );
+
+	/*!
+	 \brief Attach to a shared ring, starting at its oldest frame.
+
+	 \param name Name of the region.
+
+	 \return true if it succeeds, false if it fails.
+	 */
+	bool Open( const std::string &name );
+
+	/*!
+	 \brief Detach from the shared ring.
+	 */
+	void Close( );
+
+	/*!
+	 \brief Copy the next frame.
+
+	 \param frame Where to store the frame.
+
+	 \return true if a frame was read, false if there are no new frames.
+	 */
+	bool Read( std::vector<uint8_t> &frame );
+
+	/*!
+	 \brief Block until new frames are published or the timeout expires.
+
+	 \param timeout Maximum time to wait in milliseconds, negative to wait
+	 forever.
+	 */
+	void Wait( int timeout );
+
+	/*!
+	 \brief Copy the group records published so far.
+
+	 \param records Where to store the records.
+	 */
+	void ReadDictionary( std::vector<uint8_t> &records ) const;
+
+	/*!
+	 \brief Return the amount of times frames were overwritten before they
+	 could be read.
+
+	 \return Amount of overruns.
+	 */
+	uint64_t GetOverruns( ) const;
+
+private:
+	SharedRegion shared_region;
+	SharedRingHeader *header;
+	const uint8_t *dictionary;
+	const uint8_t *ring;
+	uint64_t read_position;
+	uint64_t overruns;
+};
+
+} // namespace xconsole
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include <SpewQueue.hpp>
+#include <cassert>
+#include <cstring>
+
+namespace xconsole
+{
+
+/*
+ Every record starts with an 8 byte header, followed by its data, padded to
+ 8 bytes. A zero header means the record is still being written. Records
+ never wrap around the end of the buffer, instead the space left at the
+ end is filled by a padding record.
+ */
+static const uint64_t header_size = sizeof( uint64_t );
+static const uint64_t padding_flag = uint64_t( 1 ) << 63;
+
+static uint64_t AlignedSize( uint64_t size )
+{
+	return ( header_size + size + 7 ) & ~uint64_t( 7 );
+}
+
+SpewQueue::SpewQueue( size_t size ) :
+	capacity( 64 ),
+	write_position( 0 ),
+	dropped( 0 ),
+	read_position( 0 )
+{
+	while( capacity < size )
+		capacity <<= 1;
+
+	buffer.resize( static_cast<size_t>( capacity / sizeof( uint64_t ) ), 0 );
+}
+
+bool SpewQueue::Push( const void *data, size_t size )
+{
+	uint8_t *record = Reserve( size );
+	if( record == nullptr )
+		return false;
+
+	std::memcpy( record, data, size );
+	Commit( record, size );
+	return true;
+}
+
+uint8_t *SpewQueue::Reserve( size_t size )
+{
+	// a zero header is what marks a record that is still being written
+	assert( size != 0 );
+
+	const uint64_t total = AlignedSize( size );
+	uint64_t position = write_position.load( std::memory_order_relaxed );
+	uint64_t padding;
+	do
+	{
+		const uint64_t remaining = capacity - ( position & ( capacity - 1 ) );
+		padding = total > remaining ? remaining : 0;
+		if( total > capacity ||
+			position + padding + total - read_position.load( std::memory_order_acquire ) > capacity )
+		{
+			dropped.fetch_add( 1, std::memory_order_relaxed );
+			return nullptr;
+		}
+	}
+	while( !write_position.compare_exchange_weak(
+		position,
+		position + padding + total,
+		std::memory_order_relaxed
+	) );
+
+	if( padding != 0 )
+	{
+		Header( position ).store( padding_flag | padding, std::memory_order_release );
+		position += padding;
+	}
+
+	return reinterpret_cast<uint8_t *>( &Header( position ) + 1 );
+}
+
+void SpewQueue::Commit( uint8_t *record, size_t size )
+{
+	assert( record != nullptr && size != 0 );
+
+	std::atomic<uint64_t> *header = reinterpret_cast<std::atomic<uint64_t> *>( record ) - 1;
+	header->store( size, std::memory_order_release );
+}
+
+const uint8_t *SpewQueue::Peek( size_t &size )
+{
+	uint64_t position = read_position.load( std::memory_order_relaxed );
+	while( true )
+	{
+		const uint64_t header = Header( position ).load( std::memory_order_acquire );
+		if( header == 0 )
+			return nullptr;
+
+		if( ( header & padding_flag ) == 0 )
+		{
+			size = static_cast<size_t>( header );
+			return reinterpret_cast<const uint8_t *>( &Header( position ) + 1 );
+		}
+
+		const uint64_t padding = header & ~padding_flag;
+		std::memset( reinterpret_cast<uint8_t *>( &Header( position ) ), 0, static_cast<size_t>( padding ) );
+		position += padding;
+		read_position.store( position, std::memory_order_release );
+	}
+}
+
+void SpewQueue::Pop( )
+{
+	const uint64_t position = read_position.load( std::memory_order_relaxed );
+	std::atomic<uint64_t> &header = Header( position );
+	const uint64_t total = AlignedSize( header.load( std::memory_order_relaxed ) );
+
+	// headers of future records can land anywhere in this space, so all of it
+	// must read as zero before producers are allowed to reuse it
+	std::memset( reinterpret_cast<uint8_t *>( &header ), 0, static_cast<size_t>( total ) );
+	read_position.store( position + total, std::memory_order_release );
+}
+
+bool SpewQueue::Empty( ) const
+{
+	const uint64_t position = read_position.load( std::memory_order_relaxed );
+	return Header( position ).load( std::memory_order_seq_cst ) == 0;
+}
+
+uint64_t SpewQueue::Dropped( ) const
+{
+	return dropped.load( std::memory_order_relaxed );
+}
+
+std::atomic<uint64_t> &SpewQueue::Header( uint64_t position )
+{
+	return reinterpret_cast<std::atomic<uint64_t> &>(
+		buffer[static_cast<size_t>( ( position & ( capacity - 1 ) ) / sizeof( uint64_t ) )]
+	);
+}
+
+const std::atomic<uint64_t> &SpewQueue::Header( uint64_t position ) const
+{
+	return reinterpret_cast<const std::atomic<uint64_t> &>(
+		buffer[static_cast<size_t>( ( position & ( capacity - 1 ) ) / sizeof( uint64_t ) )]
+	);
+}
+
+} // namespace xconsole
\ No newline at end of file
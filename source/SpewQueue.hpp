@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace xconsole
+{
+
+/*!
+ \brief A bounded, lock-free queue of variable sized records.
+
+ Any number of threads can push records while a single consumer pops them.
+ All memory is allocated up front and pushing never blocks: when the queue
+ is full, the record is dropped and accounted for.
+ */
+class SpewQueue
+{
+public:
+	/*!
+	 \brief Create a queue with the specified capacity.
+
+	 \param size Capacity in bytes, rounded up to a power of two.
+	 */
+	explicit SpewQueue( size_t size );
+
+	/*!
+	 \brief Copy a record into the queue.
+
+	 Safe to call from any thread.
+
+	 \param data Record data.
+	 \param size Size of the record.
+
+	 \return true if it succeeds, false if the queue is full.
+	 */
+	bool Push( const void *data, size_t size );
+
+	/*!
+	 \brief Reserve space for a record, to be written in place.
+
+	 Safe to call from any thread. The record is only visible to the
+	 consumer after Commit, and records reserved after it wait for it.
+
+	 \param size Exact size of the record, which can't be 0.
+
+	 \return Pointer to where the record must be written or nullptr if the
+	 queue is full.
+	 */
+	uint8_t *Reserve( size_t size );
+
+	/*!
+	 \brief Publish a record written to space returned by Reserve.
+
+	 \param record Pointer returned by Reserve.
+	 \param size Size passed to Reserve.
+	 */
+	void Commit( uint8_t *record, size_t size );
+
+	/*!
+	 \brief Return the oldest record in the queue without removing it.
+
+	 Must only be called from the consumer thread.
+
+	 \param size Where to store the size of the record.
+
+	 \return Pointer to the record data or nullptr if the queue is empty.
+	 */
+	const uint8_t *Peek( size_t &size );
+
+	/*!
+	 \brief Remove the record returned by the last call to Peek.
+
+	 Must only be called from the consumer thread.
+	 */
+	void Pop( );
+
+	/*!
+	 \brief Tell if there are no records ready to be consumed.
+
+	 \return true if the queue is empty, false otherwise.
+	 */
+	bool Empty( ) const;
+
+	/*!
+	 \brief Return the amount of records dropped because the queue was full.
+
+	 \return Amount of dropped records.
+	 */
+	uint64_t Dropped( ) const;
+
+private:
+	std::atomic<uint64_t> &Header( uint64_t position );
+	const std::atomic<uint64_t> &Header( uint64_t position ) const;
+
+	std::vector<uint64_t> buffer;
+	uint64_t capacity;
+	alignas( 64 ) std::atomic<uint64_t> write_position;
+	std::atomic<uint64_t> dropped;
+	alignas( 64 ) std::atomic<uint64_t> read_position;
+};
+
+} // namespace xconsole
\ No newline at end of file
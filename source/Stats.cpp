@@ -0,0 +1,52 @@
+#include <Stats.hpp>
+
+#if defined _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace xconsole
+{
+
+static size_t BitWidth( uint64_t value )
+{
+	if( value == 0 )
+		return 0;
+
+#if defined _MSC_VER
+	unsigned long index = 0;
+	if( _BitScanReverse( &index, static_cast<unsigned long>( value >> 32 ) ) )
+		return index + 33;
+
+	_BitScanReverse( &index, static_cast<unsigned long>( value ) );
+	return index + 1;
+#else
+	return 64 - static_cast<size_t>( __builtin_clzll( value ) );
+#endif
+}
+
+Histogram::Histogram( )
+{
+	Clear( );
+}
+
+void Histogram::Add( uint64_t ticks )
+{
+	size_t bucket = BitWidth( ticks );
+	if( bucket >= bucket_count )
+		bucket = bucket_count - 1;
+
+	buckets[bucket].fetch_add( 1, std::memory_order_relaxed );
+}
+
+uint64_t Histogram::GetBucket( size_t bucket ) const
+{
+	return buckets[bucket].load( std::memory_order_relaxed );
+}
+
+void Histogram::Clear( )
+{
+	for( std::atomic<uint64_t> &bucket : buckets )
+		bucket.store( 0, std::memory_order_relaxed );
+}
+
+} // namespace xconsole
\ No newline at end of file
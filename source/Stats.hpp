@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace xconsole
+{
+
+/*!
+ \brief Latency histogram with power of two buckets, cheap enough to update
+ on every record.
+
+ Values are clock ticks, converted to time only when read. Bucket N counts
+ values below 2^N ticks that don't fit in the previous bucket. Safe to use
+ from any thread.
+ */
+class Histogram
+{
+public:
+	/*!
+	 \brief Amount of buckets, enough for minutes worth of ticks.
+	 */
+	static const size_t bucket_count = 48;
+
+	Histogram( );
+
+	/*!
+	 \brief Count a value.
+
+	 \param ticks Value to count, in clock ticks.
+	 */
+	void Add( uint64_t ticks );
+
+	/*!
+	 \brief Return the amount of values counted in a bucket.
+
+	 \param bucket Bucket index.
+
+	 \return Amount of values.
+	 */
+	uint64_t GetBucket( size_t bucket ) const;
+
+	/*!
+	 \brief Forget every value.
+	 */
+	void Clear( );
+
+private:
+	std::atomic<uint64_t> buckets[bucket_count];
+};
+
+} // namespace xconsole
\ No newline at end of file
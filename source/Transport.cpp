@@ -0,0 +1,32 @@
+#include <Transport.hpp>
+
+#if defined _WIN32
+#include <NamedPipeTransport.hpp>
+#elif defined __linux__
+#include <UnixSocketTransport.hpp>
+#endif
+
+namespace xconsole
+{
+
+Transport *Transport::Create( )
+{
+#if defined _WIN32
+	return new NamedPipeTransport;
+#elif defined __linux__
+	return new UnixSocketTransport;
+#else
+	return nullptr;
+#endif
+}
+
+const char *Transport::DefaultPath( )
+{
+#if defined _WIN32
+	return "\\\\.\\pipe\\garrysmod_console";
+#else
+	return "@garrysmod_console";
+#endif
+}
+
+} // namespace xconsole
\ No newline at end of file
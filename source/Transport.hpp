@@ -0,0 +1,181 @@
+#pragma once
+
+#include <OutputStream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace xconsole
+{
+
+static const size_t max_write_vectors = 8;
+
+// consoles only send small control frames, anything larger is cut short
+static const size_t max_receive_size = 4096;
+
+/*!
+ \brief A single console connected through a transport.
+
+ Owned by the transport that created it.
+ */
+class Connection
+{
+public:
+	/*!
+	 \brief Values that represent the outcome of a write.
+	 */
+	enum Status
+	{
+		STATUS_OK, ///< All of the data was written
+		STATUS_BLOCKED, ///< Nothing was written because the console isn't keeping up
+		STATUS_CLOSED, ///< The console is gone and the connection must be closed
+		STATUS_DROPPED ///< Nothing was written because the data can never fit, the connection is fine
+	};
+
+	virtual ~Connection( ) { }
+
+	/*!
+	 \brief Send a single record, without blocking.
+
+	 \param data Record data.
+	 \param size Size of the record.
+
+	 \return Outcome of the write.
+	 */
+	virtual Status Write( const void *data, size_t size ) = 0;
+
+	/*!
+	 \brief Send a single record gathered from several pieces, without blocking.
+
+	 The pieces arrive as one record, exactly as if they had been copied
+	 together and sent with Write.
+
+	 \param vectors Pieces of the record, up to max_write_vectors.
+	 \param count Amount of pieces.
+
+	 \return Outcome of the write.
+	 */
+	virtual Status WriteV( const MultiLibrary::IoVector *vectors, size_t count ) = 0;
+};
+
+/*!
+ \brief Receives the events a transport handles while waiting.
+ */
+class TransportHandler
+{
+public:
+	virtual ~TransportHandler( ) { }
+
+	/*!
+	 \brief Called when a console connects.
+
+	 \param connection New connection.
+	 */
+	virtual void OnConnect( Connection *connection ) = 0;
+
+	/*!
+	 \brief Called when a console disconnects.
+
+	 The connection is destroyed after this call returns.
+
+	 \param connection Connection that was closed.
+	 */
+	virtual void OnDisconnect( Connection *connection ) = 0;
+
+	/*!
+	 \brief Called when a connection might accept writes again.
+
+	 \param connection Connection that became writable.
+	 */
+	virtual void OnWritable( Connection *connection ) = 0;
+
+	/*!
+	 \brief Called when a console sends a message.
+
+	 The connection must not be disconnected from within this call.
+
+	 \param connection Connection that sent the message.
+	 \param data Message data, only valid during this call.
+	 \param size Size of the message.
+	 */
+	virtual void OnReceive( Connection *connection, const uint8_t *data, size_t size ) = 0;
+};
+
+/*!
+ \brief An abstract class for the channels external consoles connect through.
+
+ Each platform provides its own implementation, created through Create.
+ Besides Wake and Shutdown, every function must be called from the same
+ thread, the one driving Wait.
+ */
+class Transport
+{
+public:
+	virtual ~Transport( ) { }
+
+	/*!
+	 \brief Start listening for consoles on the provided path.
+
+	 \param path Platform specific address to listen on.
+	 \param handler Object that receives connection events.
+
+	 \return true if it succeeds, false if it fails.
+	 */
+	virtual bool Open( const std::string &path, TransportHandler *handler ) = 0;
+
+	/*!
+	 \brief Disconnect all consoles and stop listening.
+	 */
+	virtual void Close( ) = 0;
+
+	/*!
+	 \brief Block until something happens or the timeout expires.
+
+	 Connection events are delivered to the handler before returning.
+
+	 \param timeout Maximum time to wait in milliseconds, negative to wait
+	 forever.
+
+	 \return false if Shutdown was called, true otherwise.
+	 */
+	virtual bool Wait( int timeout ) = 0;
+
+	/*!
+	 \brief Make the current or next call to Wait return.
+
+	 Safe to call from any thread.
+	 */
+	virtual void Wake( ) = 0;
+
+	/*!
+	 \brief Make the current and all future calls to Wait return false.
+
+	 Safe to call from any thread.
+	 */
+	virtual void Shutdown( ) = 0;
+
+	/*!
+	 \brief Close and destroy a connection.
+
+	 The handler isn't notified of disconnections requested this way.
+
+	 \param connection Connection to close.
+	 */
+	virtual void Disconnect( Connection *connection ) = 0;
+
+	/*!
+	 \brief Create the transport for the current platform.
+
+	 \return New transport object, owned by the caller.
+	 */
+	static Transport *Create( );
+
+	/*!
+	 \brief Return the path consoles connect to when none is configured.
+
+	 \return Default path for the current platform.
+	 */
+	static const char *DefaultPath( );
+};
+
+} // namespace xconsole
\ No newline at end of file
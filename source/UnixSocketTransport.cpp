@@ -0,0 +1,390 @@
+#if defined __linux__
+
+#include <UnixSocketTransport.hpp>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cassert>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace xconsole
+{
+
+static const int max_events = 32;
+
+// how long to stop accepting consoles when accepting them keeps failing
+static const int accept_backoff = 100;
+
+static void SignalEvent( int fd )
+{
+	uint64_t value = 1;
+	ssize_t result = write( fd, &value, sizeof( value ) );
+	(void)result;
+}
+
+UnixSocketConnection::UnixSocketConnection( int socket ) :
+	client_socket( socket )
+{ }
+
+UnixSocketConnection::~UnixSocketConnection( )
+{
+	if( client_socket != -1 )
+		close( client_socket );
+}
+
+Connection::Status UnixSocketConnection::Write( const void *data, size_t size )
+{
+	if( send( client_socket, data, size, MSG_DONTWAIT | MSG_NOSIGNAL ) != -1 )
+		return STATUS_OK;
+
+	if( errno == EAGAIN || errno == EWOULDBLOCK )
+		return STATUS_BLOCKED;
+
+	// packets larger than the send buffer are refused, but others still fit
+	if( errno == EMSGSIZE )
+		return STATUS_DROPPED;
+
+	return STATUS_CLOSED;
+}
+
+Connection::Status UnixSocketConnection::WriteV( const MultiLibrary::IoVector *vectors, size_t count )
+{
+	assert( count <= max_write_vectors );
+
+	// the kernel gathers the pieces into a single packet
+	iovec pieces[max_write_vectors];
+	for( size_t k = 0; k < count; ++k )
+	{
+		pieces[k].iov_base = const_cast<void *>( vectors[k].data );
+		pieces[k].iov_len = vectors[k].size;
+	}
+
+	msghdr message;
+	std::memset( &message, 0, sizeof( message ) );
+	message.msg_iov = pieces;
+	message.msg_iovlen = count;
+	if( sendmsg( client_socket, &message, MSG_DONTWAIT | MSG_NOSIGNAL ) != -1 )
+		return STATUS_OK;
+
+	if( errno == EAGAIN || errno == EWOULDBLOCK )
+		return STATUS_BLOCKED;
+
+	// packets larger than the send buffer are refused, but others still fit
+	if( errno == EMSGSIZE )
+		return STATUS_DROPPED;
+
+	return STATUS_CLOSED;
+}
+
+Connection::Status UnixSocketConnection::Read( void *data, size_t size, size_t &received )
+{
+	received = 0;
+	const ssize_t result = recv( client_socket, data, size, MSG_DONTWAIT );
+	if( result > 0 )
+	{
+		received = static_cast<size_t>( result );
+		return STATUS_OK;
+	}
+
+	// an empty message is how an orderly shutdown shows up
+	if( result == -1 && ( errno == EAGAIN || errno == EWOULDBLOCK ) )
+		return STATUS_BLOCKED;
+
+	return STATUS_CLOSED;
+}
+
+int UnixSocketConnection::GetSocket( ) const
+{
+	return client_socket;
+}
+
+UnixSocketTransport::UnixSocketTransport( ) :
+	transport_handler( nullptr ),
+	listen_socket( -1 ),
+	epoll_fd( -1 ),
+	wake_event( -1 ),
+	shutdown_event( -1 ),
+	reserve_descriptor( -1 ),
+	accept_paused( false )
+{ }
+
+UnixSocketTransport::~UnixSocketTransport( )
+{
+	Close( );
+}
+
+bool UnixSocketTransport::Open( const std::string &path, TransportHandler *handler )
+{
+	sockaddr_un address;
+	std::memset( &address, 0, sizeof( address ) );
+	address.sun_family = AF_UNIX;
+	if( path.empty( ) || path.size( ) >= sizeof( address.sun_path ) )
+		return false;
+
+	std::memcpy( address.sun_path, path.c_str( ), path.size( ) );
+	socklen_t address_size =
+		static_cast<socklen_t>( offsetof( sockaddr_un, sun_path ) + path.size( ) );
+	if( path[0] == '@' )
+		address.sun_path[0] = '\0';
+	else
+	{
+		// a previous process might have left its socket file behind
+		unlink( path.c_str( ) );
+		++address_size;
+	}
+
+	listen_socket = socket( AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+	if( listen_socket == -1 )
+		return false;
+
+	if( bind( listen_socket, reinterpret_cast<sockaddr *>( &address ), address_size ) == -1 ||
+		listen( listen_socket, SOMAXCONN ) == -1 )
+	{
+		Close( );
+		return false;
+	}
+
+	if( path[0] != '@' )
+	{
+		socket_path = path;
+		chmod( path.c_str( ), 0666 );
+	}
+
+	epoll_fd = epoll_create1( EPOLL_CLOEXEC );
+	wake_event = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+	shutdown_event = eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+	reserve_descriptor = open( "/dev/null", O_RDONLY | O_CLOEXEC );
+	accept_paused = false;
+	if( epoll_fd == -1 || wake_event == -1 || shutdown_event == -1 )
+	{
+		Close( );
+		return false;
+	}
+
+	// the addresses of our own descriptors identify them in the event data,
+	// connections use their object addresses
+	int *descriptors[] = { &listen_socket, &wake_event, &shutdown_event };
+	for( int *fd : descriptors )
+	{
+		epoll_event event;
+		event.events = EPOLLIN;
+		event.data.ptr = fd;
+		epoll_ctl( epoll_fd, EPOLL_CTL_ADD, *fd, &event );
+	}
+
+	transport_handler = handler;
+	return true;
+}
+
+void UnixSocketTransport::Close( )
+{
+	for( UnixSocketConnection *connection : connections )
+		delete connection;
+
+	connections.clear( );
+
+	for( UnixSocketConnection *connection : closed_connections )
+		delete connection;
+
+	closed_connections.clear( );
+
+	int *descriptors[] = { &shutdown_event, &wake_event, &epoll_fd, &listen_socket, &reserve_descriptor };
+	for( int *fd : descriptors )
+		if( *fd != -1 )
+		{
+			close( *fd );
+			*fd = -1;
+		}
+
+	if( !socket_path.empty( ) )
+	{
+		unlink( socket_path.c_str( ) );
+		socket_path.clear( );
+	}
+}
+
+bool UnixSocketTransport::Wait( int timeout )
+{
+	for( UnixSocketConnection *connection : closed_connections )
+		delete connection;
+
+	closed_connections.clear( );
+
+	if( accept_paused )
+		timeout = ResumeAccept( timeout );
+
+	epoll_event events[max_events];
+	int count = epoll_wait( epoll_fd, events, max_events, timeout < 0 ? -1 : timeout );
+	if( count == -1 )
+		return errno == EINTR;
+
+	for( int k = 0; k < count; ++k )
+	{
+		const epoll_event &event = events[k];
+		if( event.data.ptr == &shutdown_event )
+			return false;
+		else if( event.data.ptr == &wake_event )
+		{
+			uint64_t value;
+			ssize_t result = read( wake_event, &value, sizeof( value ) );
+			(void)result;
+		}
+		else if( event.data.ptr == &listen_socket )
+			Accept( );
+		else
+		{
+			// connections closed while handling this batch are only deleted
+			// on the next call, so their pointers can't be reused yet
+			UnixSocketConnection *connection =
+				static_cast<UnixSocketConnection *>( event.data.ptr );
+			if( connections.find( connection ) == connections.end( ) )
+				continue;
+
+			const bool received = ( event.events & EPOLLIN ) == 0 || Receive( connection );
+			if( !received || ( event.events & ( EPOLLHUP | EPOLLRDHUP | EPOLLERR ) ) != 0 )
+			{
+				transport_handler->OnDisconnect( connection );
+				Disconnect( connection );
+			}
+			else if( ( event.events & EPOLLOUT ) != 0 )
+				transport_handler->OnWritable( connection );
+		}
+	}
+
+	return true;
+}
+
+void UnixSocketTransport::Wake( )
+{
+	SignalEvent( wake_event );
+}
+
+void UnixSocketTransport::Shutdown( )
+{
+	SignalEvent( shutdown_event );
+}
+
+void UnixSocketTransport::Disconnect( Connection *connection )
+{
+	UnixSocketConnection *socket_connection = static_cast<UnixSocketConnection *>( connection );
+	if( connections.erase( socket_connection ) == 0 )
+		return;
+
+	epoll_ctl( epoll_fd, EPOLL_CTL_DEL, socket_connection->GetSocket( ), nullptr );
+	closed_connections.push_back( socket_connection );
+}
+
+void UnixSocketTransport::Accept( )
+{
+	while( true )
+	{
+		const int client = accept4( listen_socket, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC );
+		if( client == -1 )
+		{
+			const int error = errno;
+			if( error == EAGAIN || error == EWOULDBLOCK )
+				return;
+
+			if( error == EINTR || error == ECONNABORTED )
+				continue;
+
+			if( ( error == EMFILE || error == ENFILE ) && RejectPending( ) )
+				continue;
+
+			// the console stays queued and would wake us up right away, over
+			// and over, so stop listening for a while instead
+			PauseAccept( );
+			return;
+		}
+
+		UnixSocketConnection *connection = new UnixSocketConnection( client );
+
+		// edge triggered, so writability is only reported after a write blocked
+		epoll_event event;
+		event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+		event.data.ptr = connection;
+		if( epoll_ctl( epoll_fd, EPOLL_CTL_ADD, client, &event ) == -1 )
+		{
+			delete connection;
+			continue;
+		}
+
+		connections.insert( connection );
+		transport_handler->OnConnect( connection );
+	}
+}
+
+bool UnixSocketTransport::RejectPending( )
+{
+	if( reserve_descriptor == -1 )
+		return false;
+
+	// out of descriptors, the spare one makes room to turn the console away
+	close( reserve_descriptor );
+	const int client = accept4( listen_socket, nullptr, nullptr, SOCK_CLOEXEC );
+	if( client != -1 )
+		close( client );
+
+	reserve_descriptor = open( "/dev/null", O_RDONLY | O_CLOEXEC );
+	return client != -1;
+}
+
+void UnixSocketTransport::PauseAccept( )
+{
+	epoll_ctl( epoll_fd, EPOLL_CTL_DEL, listen_socket, nullptr );
+	accept_paused = true;
+	accept_resume = std::chrono::steady_clock::now( ) + std::chrono::milliseconds( accept_backoff );
+}
+
+int UnixSocketTransport::ResumeAccept( int timeout )
+{
+	const int remaining = static_cast<int>( std::chrono::duration_cast<std::chrono::milliseconds>(
+		accept_resume - std::chrono::steady_clock::now( )
+	).count( ) );
+	if( remaining > 0 )
+		return timeout < 0 || timeout > remaining ? remaining : timeout;
+
+	epoll_event event;
+	event.events = EPOLLIN;
+	event.data.ptr = &listen_socket;
+	epoll_ctl( epoll_fd, EPOLL_CTL_ADD, listen_socket, &event );
+	accept_paused = false;
+	return timeout;
+}
+
+bool UnixSocketTransport::Receive( UnixSocketConnection *connection )
+{
+	// edge triggered, so everything pending has to be read now
+	uint8_t message[max_receive_size];
+	while( true )
+	{
+		size_t received = 0;
+		switch( connection->Read( message, sizeof( message ), received ) )
+		{
+		case Connection::STATUS_OK:
+			transport_handler->OnReceive( connection, message, received );
+			break;
+
+		case Connection::STATUS_BLOCKED:
+			return true;
+
+		case Connection::STATUS_CLOSED:
+			return false;
+
+		case Connection::STATUS_DROPPED:
+			// only writes are ever dropped
+			break;
+		}
+	}
+}
+
+} // namespace xconsole
+
+#endif
\ No newline at end of file
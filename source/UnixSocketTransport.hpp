@@ -0,0 +1,83 @@
+#pragma once
+
+#if defined __linux__
+
+#include <Transport.hpp>
+#include <chrono>
+#include <set>
+#include <vector>
+
+namespace xconsole
+{
+
+/*!
+ \brief Connection to a console through a Unix domain socket.
+ */
+class UnixSocketConnection : public Connection
+{
+public:
+	explicit UnixSocketConnection( int socket );
+	~UnixSocketConnection( );
+
+	Status Write( const void *data, size_t size );
+	Status WriteV( const MultiLibrary::IoVector *vectors, size_t count );
+
+	/*!
+	 \brief Receive a single message, without blocking.
+
+	 \param data Where to store the message, truncated if it doesn't fit.
+	 \param size Size of the provided buffer.
+	 \param received Set to the size of the message.
+
+	 \return Outcome of the read, STATUS_BLOCKED when nothing was received.
+	 */
+	Status Read( void *data, size_t size, size_t &received );
+
+	int GetSocket( ) const;
+
+private:
+	int client_socket;
+};
+
+/*!
+ \brief Transport based on a Unix domain socket of the SOCK_SEQPACKET type.
+
+ Paths starting with '@' are bound in the abstract namespace. Waiting is
+ done on epoll, with eventfds for waking up and shutting down.
+ */
+class UnixSocketTransport : public Transport
+{
+public:
+	UnixSocketTransport( );
+	~UnixSocketTransport( );
+
+	bool Open( const std::string &path, TransportHandler *handler );
+	void Close( );
+	bool Wait( int timeout );
+	void Wake( );
+	void Shutdown( );
+	void Disconnect( Connection *connection );
+
+private:
+	void Accept( );
+	bool RejectPending( );
+	void PauseAccept( );
+	int ResumeAccept( int timeout );
+	bool Receive( UnixSocketConnection *connection );
+
+	std::string socket_path;
+	TransportHandler *transport_handler;
+	int listen_socket;
+	int epoll_fd;
+	int wake_event;
+	int shutdown_event;
+	int reserve_descriptor; ///< Given up to turn consoles away when out of descriptors
+	bool accept_paused;
+	std::chrono::steady_clock::time_point accept_resume;
+	std::set<UnixSocketConnection *> connections;
+	std::vector<UnixSocketConnection *> closed_connections;
+};
+
+} // namespace xconsole
+
+#endif
\ No newline at end of file
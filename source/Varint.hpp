@@ -0,0 +1,295 @@
+#pragma once
+
+#include <BufferView.hpp>
+#include <InputStream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace xconsole
+{
+
+/*
+ Variable length integers, as LEB128: 7 bits per byte, least significant
+ first, with the top bit of every byte but the last one set. Signed values
+ are zigzag encoded first (0, -1, 1, -2, ... become 0, 1, 2, 3, ...), so
+ small negative values stay small too.
+
+ Values under 128 take a single byte, and a 64-bit value takes up to 10.
+ */
+
+static const size_t max_varint_size = 10;
+
+/*!
+ \brief Map a signed value to an unsigned one, keeping small values small.
+
+ \param value Value to map.
+
+ \return Zigzag encoded value.
+ */
+inline uint64_t EncodeZigZag( int64_t value )
+{
+	return ( static_cast<uint64_t>( value ) << 1 ) ^ static_cast<uint64_t>( value >> 63 );
+}
+
+/*!
+ \brief Undo EncodeZigZag.
+
+ \param value Zigzag encoded value.
+
+ \return Signed value.
+ */
+inline int64_t DecodeZigZag( uint64_t value )
+{
+	return static_cast<int64_t>( ( value >> 1 ) ^ ( ~( value & 1 ) + 1 ) );
+}
+
+/*!
+ \brief Return how many bytes a value takes as a varint.
+
+ \param value Value to measure.
+
+ \return Encoded size, from 1 to max_varint_size.
+ */
+inline size_t VarintSize( uint64_t value )
+{
+	size_t size = 1;
+	while( value >= 0x80 )
+	{
+		value >>= 7;
+		++size;
+	}
+
+	return size;
+}
+
+/*!
+ \brief Encode a varint into memory.
+
+ \param value Value to encode.
+ \param data Where to write, with room for max_varint_size bytes.
+
+ \return Amount of bytes written.
+ */
+inline size_t EncodeVarint( uint64_t value, uint8_t *data )
+{
+	size_t size = 0;
+	while( value >= 0x80 )
+	{
+		data[size++] = static_cast<uint8_t>( value | 0x80 );
+		value >>= 7;
+	}
+
+	data[size++] = static_cast<uint8_t>( value );
+	return size;
+}
+
+// index of the lowest set bit of a non-zero value
+inline size_t LowestSetBit( uint64_t value )
+{
+#if defined _MSC_VER
+	unsigned long index = 0;
+	if( _BitScanForward( &index, static_cast<unsigned long>( value ) ) )
+		return index;
+
+	_BitScanForward( &index, static_cast<unsigned long>( value >> 32 ) );
+	return index + 32;
+#else
+	return static_cast<size_t>( __builtin_ctzll( value ) );
+#endif
+}
+
+/*!
+ \brief Decode a varint from memory.
+
+ Varints of up to 8 bytes (56 bits) with at least 8 readable bytes are
+ decoded without branching on every byte, the rest a byte at a time.
+
+ \param data Memory to read from.
+ \param size Amount of readable bytes.
+ \param value Where to store the value.
+
+ \return Amount of bytes read, or 0 if the varint is truncated or too long.
+ */
+inline size_t DecodeVarint( const uint8_t *data, size_t size, uint64_t &value )
+{
+	if( size >= sizeof( uint64_t ) )
+	{
+		// varints are little endian, like everything else in the protocol
+		uint64_t word = 0;
+		std::memcpy( &word, data, sizeof( word ) );
+		const uint64_t ends = ~word & 0x8080808080808080ULL;
+		if( ends != 0 )
+		{
+			const size_t length = LowestSetBit( ends ) / 8 + 1;
+			if( length < sizeof( uint64_t ) )
+				word &= ( uint64_t( 1 ) << ( length * 8 ) ) - 1;
+
+			// squeeze the 7-bit groups together, pairs, then quads, then halves
+			word &= 0x7F7F7F7F7F7F7F7FULL;
+			word = ( ( word & 0x7F007F007F007F00ULL ) >> 1 ) | ( word & 0x007F007F007F007FULL );
+			word = ( ( word & 0x3FFF00003FFF0000ULL ) >> 2 ) | ( word & 0x00003FFF00003FFFULL );
+			word = ( ( word & 0x0FFFFFFF00000000ULL ) >> 4 ) | ( word & 0x000000000FFFFFFFULL );
+			value = word;
+			return length;
+		}
+	}
+
+	uint64_t result = 0;
+	for( size_t k = 0; k < size && k < max_varint_size; ++k )
+	{
+		const uint8_t byte = data[k];
+		if( k == max_varint_size - 1 && byte > 1 )
+			return 0;
+
+		result |= static_cast<uint64_t>( byte & 0x7F ) << ( 7 * k );
+		if( ( byte & 0x80 ) == 0 )
+		{
+			value = result;
+			return k + 1;
+		}
+	}
+
+	return 0;
+}
+
+/*!
+ \brief Write a varint to a stream or writer.
+
+ \param stream Anything with a Write( data, size ) method.
+ \param value Value to write.
+ */
+template<typename Stream>
+inline void WriteVarint( Stream &stream, uint64_t value )
+{
+	uint8_t data[max_varint_size];
+	stream.Write( data, EncodeVarint( value, data ) );
+}
+
+/*!
+ \brief Write a zigzag encoded varint to a stream or writer.
+
+ \param stream Anything with a Write( data, size ) method.
+ \param value Value to write.
+ */
+template<typename Stream>
+inline void WriteZigZag( Stream &stream, int64_t value )
+{
+	WriteVarint( stream, EncodeZigZag( value ) );
+}
+
+/*!
+ \brief Read a varint from a view.
+
+ \param view View to read from.
+ \param value Where to store the value.
+
+ \return false if the varint is truncated or too long, true otherwise.
+ */
+inline bool ReadVarint( BufferView &view, uint64_t &value )
+{
+	// failing to skip past the end invalidates the view, like any other bad read
+	const size_t length = DecodeVarint( view.Data( ), view.Remaining( ), value );
+	return view.Skip( length != 0 ? length : view.Remaining( ) + 1 );
+}
+
+/*!
+ \brief Read a varint from a stream.
+
+ Contiguous streams are decoded in place, others a byte at a time.
+
+ \param stream Stream to read from.
+ \param value Where to store the value.
+
+ \return false if the varint is truncated or too long, true otherwise.
+
+ \overload
+ */
+inline bool ReadVarint( MultiLibrary::InputStream &stream, uint64_t &value )
+{
+	size_t size = 0;
+	const uint8_t *data = stream.Peek( size );
+	if( data != nullptr )
+	{
+		const size_t length = DecodeVarint( data, size, value );
+		if( length != 0 )
+			return stream.Seek( static_cast<int64_t>( length ), MultiLibrary::SEEKMODE_CUR );
+
+		// the piece can end in the middle of a varint in segmented streams
+		if( size >= max_varint_size )
+			return false;
+	}
+
+	uint8_t bytes[max_varint_size];
+	for( size_t k = 0; k < max_varint_size; ++k )
+	{
+		if( stream.Read( &bytes[k], 1 ) != 1 )
+			return false;
+
+		if( ( bytes[k] & 0x80 ) == 0 )
+			return DecodeVarint( bytes, k + 1, value ) != 0;
+	}
+
+	return false;
+}
+
+/*!
+ \brief Read a varint that must fit in a narrower type.
+
+ \param stream Stream or view to read from.
+ \param value Where to store the value, left untouched on failure.
+
+ \return false if the varint is truncated, too long or out of range, true
+ otherwise.
+
+ \overload
+ */
+template<typename Stream, typename Value>
+inline typename std::enable_if<!std::is_same<Value, uint64_t>::value, bool>::type ReadVarint(
+	Stream &stream,
+	Value &value
+)
+{
+	static_assert( std::is_unsigned<Value>::value, "varints are unsigned, use ReadZigZag" );
+
+	uint64_t wide = 0;
+	if( !ReadVarint( stream, wide ) || wide > std::numeric_limits<Value>::max( ) )
+		return false;
+
+	value = static_cast<Value>( wide );
+	return true;
+}
+
+/*!
+ \brief Read a zigzag encoded varint.
+
+ \param stream Stream or view to read from.
+ \param value Where to store the value, left untouched on failure.
+
+ \return false if the varint is truncated, too long or out of range, true
+ otherwise.
+ */
+template<typename Stream, typename Value>
+inline bool ReadZigZag( Stream &stream, Value &value )
+{
+	static_assert( std::is_signed<Value>::value, "zigzag varints are signed, use ReadVarint" );
+
+	uint64_t wide = 0;
+	if( !ReadVarint( stream, wide ) )
+		return false;
+
+	const int64_t decoded = DecodeZigZag( wide );
+	if( decoded < std::numeric_limits<Value>::min( ) || decoded > std::numeric_limits<Value>::max( ) )
+		return false;
+
+	value = static_cast<Value>( decoded );
+	return true;
+}
+
+} // namespace xconsole
\ No newline at end of file
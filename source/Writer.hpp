@@ -0,0 +1,264 @@
+#pragma once
+
+#include <ByteBuffer.hpp>
+#include <MemoryBuffer.hpp>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace xconsole
+{
+
+/*!
+ \brief How Writer reaches the memory of a sink.
+
+ Specialized for every contiguous sink Writer can write to. Each
+ specialization provides Data, Position and Size to find the memory,
+ Grow to make room for more (returning false for fixed sinks) and Finish
+ to settle the final size and position.
+ */
+template<typename Sink>
+struct WriterSink;
+
+template<>
+struct WriterSink<MultiLibrary::ByteBuffer>
+{
+	static uint8_t *Data( MultiLibrary::ByteBuffer &sink )
+	{
+		return sink.Size( ) != 0 ? sink.GetBuffer( ) : nullptr;
+	}
+
+	static size_t Position( const MultiLibrary::ByteBuffer &sink )
+	{
+		return static_cast<size_t>( sink.Tell( ) );
+	}
+
+	static size_t Size( const MultiLibrary::ByteBuffer &sink )
+	{
+		return static_cast<size_t>( sink.Size( ) );
+	}
+
+	static bool Grow( MultiLibrary::ByteBuffer &sink, size_t size )
+	{
+		sink.Resize( size );
+		return true;
+	}
+
+	static void Finish( MultiLibrary::ByteBuffer &sink, size_t size, size_t position )
+	{
+		sink.Resize( size );
+		sink.Seek( static_cast<int64_t>( position ) );
+	}
+};
+
+template<>
+struct WriterSink<MultiLibrary::MemoryBuffer>
+{
+	static uint8_t *Data( MultiLibrary::MemoryBuffer &sink )
+	{
+		return sink.GetBuffer( );
+	}
+
+	static size_t Position( const MultiLibrary::MemoryBuffer &sink )
+	{
+		return static_cast<size_t>( sink.Tell( ) );
+	}
+
+	static size_t Size( const MultiLibrary::MemoryBuffer &sink )
+	{
+		return static_cast<size_t>( sink.Size( ) );
+	}
+
+	static bool Grow( MultiLibrary::MemoryBuffer &, size_t )
+	{
+		return false;
+	}
+
+	static void Finish( MultiLibrary::MemoryBuffer &sink, size_t, size_t position )
+	{
+		sink.Seek( static_cast<int64_t>( position ) );
+	}
+};
+
+/*!
+ \brief Inlinable writer for contiguous sinks.
+
+ Writes the same bytes as the OutputStream operators, but straight into
+ the memory of the sink, so every value is a bounds check and a store
+ instead of two virtual calls. The sink must not be used while a writer
+ is working on it, its size and position are only settled by Finish (or
+ the destructor).
+
+ Fixed sinks write as much as fits, after which the writer stops writing
+ and is no longer valid, like MemoryBuffer.
+ */
+template<typename Sink>
+class Writer
+{
+public:
+	/*!
+	 \brief Start writing at the current position of a sink.
+
+	 \param target Sink to write to.
+	 */
+	explicit Writer( Sink &target ) :
+		sink( target ),
+		base( WriterSink<Sink>::Data( target ) ),
+		cursor( base + WriterSink<Sink>::Position( target ) ),
+		limit( base + WriterSink<Sink>::Size( target ) ),
+		initial_size( WriterSink<Sink>::Size( target ) ),
+		valid( true ),
+		finished( false )
+	{ }
+
+	~Writer( )
+	{
+		Finish( );
+	}
+
+	/*!
+	 \brief Settle the size and position of the sink.
+
+	 Happens on destruction as well, only the first call has any effect.
+	 */
+	void Finish( )
+	{
+		if( finished )
+			return;
+
+		finished = true;
+		const size_t position = static_cast<size_t>( cursor - base );
+		WriterSink<Sink>::Finish( sink, position > initial_size ? position : initial_size, position );
+	}
+
+	/*!
+	 \brief Tell if everything fit in the sink.
+
+	 \return false if a fixed sink ran out of space, true otherwise.
+	 */
+	bool IsValid( ) const
+	{
+		return valid;
+	}
+
+	/*!
+	 \brief Return the current position on the sink.
+
+	 \return Position of the next write.
+	 */
+	size_t Tell( ) const
+	{
+		return static_cast<size_t>( cursor - base );
+	}
+
+	/*!
+	 \brief Make room for the specified amount of bytes.
+
+	 Writers grow sinks by doubling them, reserving what's about to be
+	 written avoids growing them further than needed.
+
+	 \param size Amount of bytes about to be written.
+
+	 \return false if a fixed sink doesn't have enough space, true otherwise.
+	 */
+	bool Reserve( size_t size )
+	{
+		if( static_cast<size_t>( limit - cursor ) >= size )
+			return true;
+
+		return Grow( size, static_cast<size_t>( cursor - base ) + size );
+	}
+
+	/*!
+	 \brief Write the specified amount of bytes from the provided buffer.
+
+	 \param data Data to write.
+	 \param size Size of the data.
+
+	 \return Amount of written bytes.
+	 */
+	size_t Write( const void *data, size_t size )
+	{
+		if( static_cast<size_t>( limit - cursor ) < size && !Grow( size, 0 ) )
+			size = static_cast<size_t>( limit - cursor );
+
+		if( size != 0 )
+			std::memcpy( cursor, data, size );
+
+		cursor += size;
+		return size;
+	}
+
+	/*!
+	 \brief Write an arithmetic value, with the same layout as OutputStream.
+
+	 \param data Value to write.
+
+	 \return This object.
+	 */
+	template<typename Value>
+	Writer &operator<<( const Value &data )
+	{
+		static_assert( std::is_arithmetic<Value>::value, "only arithmetic values can be written" );
+
+		if( static_cast<size_t>( limit - cursor ) >= sizeof( Value ) || Grow( sizeof( Value ), 0 ) )
+		{
+			std::memcpy( cursor, &data, sizeof( Value ) );
+			cursor += sizeof( Value );
+		}
+
+		return *this;
+	}
+
+	/*!
+	 \brief Write a string, NUL terminated like OutputStream does.
+
+	 \param data String to write.
+
+	 \return This object.
+
+	 \overload
+	 */
+	Writer &operator<<( const std::string &data )
+	{
+		Write( data.c_str( ), data.size( ) + 1 );
+		return *this;
+	}
+
+private:
+	Writer( const Writer & );
+	Writer &operator=( const Writer & );
+
+	// growth doubles the space unless told exactly how much is needed
+	bool Grow( size_t size, size_t exact )
+	{
+		const size_t position = static_cast<size_t>( cursor - base );
+		size_t capacity = exact != 0 ? exact : static_cast<size_t>( limit - base ) * 2;
+		if( capacity < position + size )
+			capacity = position + size;
+
+		if( !valid || !WriterSink<Sink>::Grow( sink, capacity ) )
+		{
+			valid = false;
+			return false;
+		}
+
+		base = WriterSink<Sink>::Data( sink );
+		cursor = base + position;
+		limit = base + capacity;
+		return true;
+	}
+
+	Sink &sink;
+	uint8_t *base;
+	uint8_t *cursor;
+	uint8_t *limit;
+	size_t initial_size;
+	bool valid;
+	bool finished;
+};
+
+typedef Writer<MultiLibrary::ByteBuffer> BufferWriter;
+
+} // namespace xconsole
\ No newline at end of file
@@ -1,92 +1,277 @@
 #include <GarrysMod/Lua/Interface.h>
-#include <ByteBuffer.hpp>
+#include <Server.hpp>
+#include <Transport.hpp>
 #include <dbg.h>
 #include <Color.h>
-#include <Windows.h>
+#include <tier0/icommandline.h>
+#include <climits>
 #include <cstdint>
+#include <cstring>
 #include <string>
-#include <thread>
+#include <vector>
 
 static SpewOutputFunc_t spew_function = nullptr;
-static HANDLE server_pipe = INVALID_HANDLE_VALUE;
-static volatile bool server_shutdown = false;
-static volatile bool server_connected = false;
-static std::thread server_thread;
+static xconsole::Server server;
 
-static void ServerThread( )
+// frames are sent as single packets on Linux, which must fit the socket's
+// send buffer, so batches are kept well under its usual size
+static const int max_batch_bytes = 64 * 1024;
+
+static xconsole::BackpressurePolicy ParsePolicy( const char *name, xconsole::BackpressurePolicy fallback )
+{
+	static const char *names[xconsole::POLICY_COUNT] = {
+		"drop_newest",
+		"drop_oldest",
+		"block",
+		"sample"
+	};
+
+	for( int k = 0; k < xconsole::POLICY_COUNT; ++k )
+		if( std::strcmp( name, names[k] ) == 0 )
+			return static_cast<xconsole::BackpressurePolicy>( k );
+
+	if( name[0] != '\0' )
+		Warning( "xconsole: unknown policy '%s', using %s\n", name, names[fallback] );
+
+	return fallback;
+}
+
+static int ParseInt(
+	ICommandLine *command_line,
+	const char *name,
+	int fallback,
+	int minimum = 1,
+	int maximum = INT_MAX
+)
 {
-	while( !server_shutdown )
+	const int value = command_line->ParmValue( name, fallback );
+	if( value < minimum || value > maximum )
 	{
-		if( ConnectNamedPipe( server_pipe, nullptr ) == FALSE )
-		{
-			DWORD error = GetLastError( );
-			if( error == ERROR_NO_DATA )
-			{
-				DisconnectNamedPipe( server_pipe );
-				server_connected = false;
-			}
-			else if( error == ERROR_PIPE_CONNECTED )
-				server_connected = true;
-		}
+		if( maximum == INT_MAX )
+			Warning( "xconsole: ignoring %s %d, it must be %d or more\n", name, value, minimum );
 		else
-			server_connected = true;
+			Warning(
+				"xconsole: ignoring %s %d, it must be from %d to %d\n",
+				name,
+				value,
+				minimum,
+				maximum
+			);
+
+		return fallback;
+	}
+
+	return value;
+}
+
+static size_t ParseSize(
+	ICommandLine *command_line,
+	const char *name,
+	size_t fallback,
+	size_t unit = 1,
+	int minimum = 1,
+	int maximum = INT_MAX
+)
+{
+	// the default is passed in units, so it comes back unchanged when missing
+	const int value = ParseInt(
+		command_line,
+		name,
+		static_cast<int>( fallback / unit ),
+		minimum,
+		maximum
+	);
+	return static_cast<size_t>( value ) * unit;
+}
+
+static uint64_t Percentile( const std::vector<xconsole::LatencyBucket> &buckets, uint64_t total, double fraction )
+{
+	uint64_t count = 0;
+	for( const xconsole::LatencyBucket &bucket : buckets )
+	{
+		count += bucket.count;
+		if( static_cast<double>( count ) >= static_cast<double>( total ) * fraction )
+			return bucket.limit;
+	}
+
+	return 0;
+}
+
+static void PushHistogram( GarrysMod::Lua::ILuaBase *LUA, const std::vector<xconsole::LatencyBucket> &buckets )
+{
+	uint64_t total = 0;
+	for( const xconsole::LatencyBucket &bucket : buckets )
+		total += bucket.count;
+
+	// percentiles are bucket limits, in nanoseconds, so they're rounded up
+	LUA->CreateTable( );
+	LUA->PushNumber( static_cast<double>( total ) );
+	LUA->SetField( -2, "count" );
+	LUA->PushNumber( static_cast<double>( Percentile( buckets, total, 0.5 ) ) );
+	LUA->SetField( -2, "p50" );
+	LUA->PushNumber( static_cast<double>( Percentile( buckets, total, 0.99 ) ) );
+	LUA->SetField( -2, "p99" );
+	LUA->PushNumber( static_cast<double>( Percentile( buckets, total, 0.999 ) ) );
+	LUA->SetField( -2, "p999" );
+	LUA->PushNumber( static_cast<double>( buckets.empty( ) ? 0 : buckets.back( ).limit ) );
+	LUA->SetField( -2, "max" );
+
+	LUA->CreateTable( );
+	for( size_t k = 0; k < buckets.size( ); ++k )
+	{
+		LUA->PushNumber( static_cast<double>( k + 1 ) );
+		LUA->CreateTable( );
+		LUA->PushNumber( static_cast<double>( buckets[k].limit ) );
+		LUA->SetField( -2, "limit" );
+		LUA->PushNumber( static_cast<double>( buckets[k].count ) );
+		LUA->SetField( -2, "count" );
+		LUA->SetTable( -3 );
+	}
 
-		Sleep( 1 );
+	LUA->SetField( -2, "buckets" );
+}
+
+LUA_FUNCTION_STATIC( GetStats )
+{
+	static const char *counter_names[xconsole::STATS_COUNTER_COUNT] = {
+		"records",
+		"record_bytes",
+		"queue_drops",
+		"client_drops",
+		"frames",
+		"frame_bytes",
+		"connects",
+		"disconnects",
+		"blocked_writes",
+		"write_errors",
+		"filter_errors"
+	};
+
+	static const char *histogram_names[xconsole::STATS_HISTOGRAM_COUNT] = {
+		"encode",
+		"enqueue",
+		"write"
+	};
+
+	xconsole::StatsRecord stats;
+	server.GetStats( stats );
+
+	LUA->CreateTable( );
+	for( size_t k = 0; k < stats.counters.size( ); ++k )
+	{
+		LUA->PushNumber( static_cast<double>( stats.counters[k] ) );
+		LUA->SetField( -2, counter_names[k] );
+	}
+
+	LUA->CreateTable( );
+	for( size_t k = 0; k < xconsole::STATS_HISTOGRAM_COUNT; ++k )
+	{
+		PushHistogram( LUA, stats.histograms[k] );
+		LUA->SetField( -2, histogram_names[k] );
+	}
+
+	LUA->SetField( -2, "latency" );
+
+	LUA->CreateTable( );
+	for( size_t k = 0; k < stats.clients.size( ); ++k )
+	{
+		const xconsole::ClientStats &client = stats.clients[k];
+		LUA->PushNumber( static_cast<double>( k + 1 ) );
+		LUA->CreateTable( );
+		LUA->PushNumber( client.queued_frames );
+		LUA->SetField( -2, "queued_frames" );
+		LUA->PushNumber( static_cast<double>( client.queued_bytes ) );
+		LUA->SetField( -2, "queued_bytes" );
+		LUA->PushNumber( static_cast<double>( client.dropped ) );
+		LUA->SetField( -2, "dropped" );
+		LUA->PushNumber( client.policy );
+		LUA->SetField( -2, "policy" );
+		LUA->SetTable( -3 );
 	}
+
+	LUA->SetField( -2, "clients" );
+	return 1;
 }
 
 static SpewRetval_t EngineSpewReceiver( SpewType_t type, const char *msg )
 {
-	if( !server_connected )
+	if( !server.WantsRecords( ) )
 		return spew_function( type, msg );
 
-	const Color *color = GetSpewOutputColor( );
-	MultiLibrary::ByteBuffer buffer;
-	buffer.Reserve( 512 );
-	buffer <<
-		static_cast<int32_t>( type ) <<
-		GetSpewOutputLevel( ) <<
-		GetSpewOutputGroup( ) <<
-		color->GetRawColor( ) <<
-		msg;
-
-	if( WriteFile(
-		server_pipe,
-		buffer.GetBuffer( ),
-		static_cast<DWORD>( buffer.Size( ) ),
-		nullptr,
-		nullptr
-	) == FALSE )
-		server_connected = false;
+	server.Capture(
+		static_cast<int32_t>( type ),
+		GetSpewOutputLevel( ),
+		GetSpewOutputGroup( ),
+		GetSpewOutputColor( )->GetRawColor( ),
+		msg
+	);
 
 	return spew_function( type, msg );
 }
 
 GMOD_MODULE_OPEN( )
 {
-	SECURITY_DESCRIPTOR sd;
-	InitializeSecurityDescriptor( &sd, SECURITY_DESCRIPTOR_REVISION );
-	SetSecurityDescriptorDacl( &sd, TRUE, nullptr, FALSE );
-
-	SECURITY_ATTRIBUTES sa;
-	sa.nLength = sizeof( sa );
-	sa.lpSecurityDescriptor = &sd;
-	sa.bInheritHandle = FALSE;
-
-	server_pipe = CreateNamedPipe(
-		"\\\\.\\pipe\\garrysmod_console",
-		PIPE_ACCESS_OUTBOUND,
-		PIPE_TYPE_MESSAGE | PIPE_NOWAIT,
-		PIPE_UNLIMITED_INSTANCES,
-		8192,
-		8192,
-		NMPWAIT_USE_DEFAULT_WAIT,
-		&sa
+	ICommandLine *command_line = CommandLine( );
+	const char *path = command_line->ParmValue(
+		"-xconsole_path",
+		xconsole::Transport::DefaultPath( )
+	);
+
+	xconsole::ServerOptions options;
+	options.batch_bytes = ParseSize(
+		command_line,
+		"-xconsole_batch_bytes",
+		options.batch_bytes,
+		1,
+		1,
+		max_batch_bytes
+	);
+	options.batch_records = ParseSize( command_line, "-xconsole_batch_records", options.batch_records );
+	options.flush_interval = ParseInt(
+		command_line,
+		"-xconsole_flush_interval",
+		options.flush_interval,
+		0
+	);
+	options.low_latency = command_line->FindParm( "-xconsole_coalesce" ) == 0;
+	options.compression = command_line->FindParm( "-xconsole_nocompress" ) == 0;
+
+	xconsole::ClientPolicy &policy = options.client_policy;
+	policy.policy = ParsePolicy(
+		command_line->ParmValue( "-xconsole_policy", "" ),
+		policy.policy
 	);
-	if( server_pipe == INVALID_HANDLE_VALUE )
-		LUA->ThrowError( "failed to create named pipe" );
+	policy.budget = ParseSize( command_line, "-xconsole_client_budget", policy.budget );
+	policy.block_timeout = ParseInt( command_line, "-xconsole_block_timeout", policy.block_timeout, 0 );
+	policy.sample_rate = static_cast<uint32_t>(
+		ParseSize( command_line, "-xconsole_sample_rate", policy.sample_rate )
+	);
+
+	if( command_line->FindParm( "-xconsole_shm" ) != 0 )
+	{
+		options.shared_name = command_line->ParmValue( "-xconsole_shm", "" );
+		if( options.shared_name.empty( ) || options.shared_name[0] == '-' )
+			options.shared_name = "garrysmod_console";
+	}
+
+	options.shared_size = ParseSize( command_line, "-xconsole_shm_size", options.shared_size, 1024 * 1024 );
+	options.history_size = ParseSize(
+		command_line,
+		"-xconsole_history",
+		options.history_size,
+		1024 * 1024,
+		0
+	);
+
+	if( !server.Start( path, options ) )
+		LUA->ThrowError( "failed to open console transport" );
 
-	server_thread = std::thread( ServerThread );
+	LUA->PushSpecial( GarrysMod::Lua::SPECIAL_GLOB );
+	LUA->CreateTable( );
+	LUA->PushCFunction( GetStats );
+	LUA->SetField( -2, "GetStats" );
+	LUA->SetField( -2, "xconsole" );
+	LUA->Pop( );
 
 	spew_function = GetSpewOutputFunc( );
 	SpewOutputFunc( EngineSpewReceiver );
@@ -98,12 +283,12 @@ GMOD_MODULE_CLOSE( )
 {
 	SpewOutputFunc( spew_function );
 
-	server_shutdown = true;
-	server_thread.join( );
+	LUA->PushSpecial( GarrysMod::Lua::SPECIAL_GLOB );
+	LUA->PushNil( );
+	LUA->SetField( -2, "xconsole" );
+	LUA->Pop( );
 
-	FlushFileBuffers( server_pipe );
-	DisconnectNamedPipe( server_pipe );
-	CloseHandle( server_pipe );
+	server.Stop( );
 
 	return 0;
 }
\ No newline at end of file